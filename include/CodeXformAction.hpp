@@ -26,11 +26,20 @@
 #define CODE_XFORM_ACTION_HPP
 
 #include "MatchCallbackBase.hpp"
+#include "CodeXformOptions.hpp"
+#include "FindIndex.hpp"
+#include "MatchCounts.hpp"
+#include "MatchLimit.hpp"
+#include "Sampling.hpp"
+#include "VisitorCallbackBase.hpp"
 
+#include <chrono>
 #include <vector>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_set>
+#include <unordered_map>
 
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
@@ -41,26 +50,80 @@ namespace clang {
 class CompilerInstance;
 } // end of namespace clang
 
+// State of CodeXformAction independent of the file processed: the matchers,
+// their callbacks with parsed options, and the traversal scope. Building it is
+// costly with many matcher instances, so it is built once and reused by all the
+// actions run in sequence by the same thread.
+class CodeXformState
+{
+ public:
+  CodeXformState(const std::vector<std::string>& ids,
+                 const std::vector<std::string>& args,
+                 const CodeXformOptions& options = CodeXformOptions());
+  CodeXformState(const CodeXformState&) = delete;
+  CodeXformState& operator=(const CodeXformState&) = delete;
+
+  // release the state kept for the current file
+  void Reset();
+
+ private:
+  friend class CodeXformAction;
+
+  clang::ast_matchers::MatchFinder mFinder;
+  VisitorDispatcher mDispatcher;
+  // some callbacks register matchers, otherwise only mDispatcher traverses the AST
+  bool mHasMatchers = false;
+  clang::tooling::Replacements mReplacements;
+  std::vector<std::unique_ptr<MatchCallbackBase> > mCallbacks;
+  // skip function bodies outside the main file
+  bool mMainFileOnly = false;
+  // only traverse top-level declarations in the main file and mScopeHeaders
+  bool mMainFileScope = false;
+  std::unordered_set<std::string> mScopeHeaders;
+  // only traverse top-level declarations of headers owned by the main file
+  std::shared_ptr<const std::unordered_map<std::string, std::string> > mHeaderOwners;
+  std::shared_ptr<MemoryBudget> mMemoryBudget;
+  // with a find index, the nodes found in the current file are appended to it
+  // and the replacements are dropped
+  std::shared_ptr<FindIndex> mFindIndex;
+  FindIndexBlock mFindHits;
+  // with match counts, the nodes found in the current file are only counted
+  std::shared_ptr<MatchCounts> mMatchCounts;
+  std::shared_ptr<SampleStats> mSampleStats;
+  // once reached, the files being parsed stop as soon as possible
+  std::shared_ptr<MatchLimit> mMatchLimit;
+};
+
 class CodeXformAction : public clang::ASTFrontendAction
 {
  public:
   explicit CodeXformAction(const std::string& outputFile,
                            const std::vector<std::string>& ids,
-                           const std::vector<std::string>& args);
+                           const std::vector<std::string>& args,
+                           const CodeXformOptions& options = CodeXformOptions());
+  // the given state must not be used by another action at the same time
+  CodeXformAction(const std::string& outputFile, std::shared_ptr<CodeXformState> state);
+  ~CodeXformAction();
 
  protected:
   virtual std::unique_ptr<clang::ASTConsumer>
-  CreateASTConsumer(clang::CompilerInstance &, llvm::StringRef) override
-  {
-    return mFinder.newASTConsumer();
-  }
+  CreateASTConsumer(clang::CompilerInstance &, llvm::StringRef) override;
   virtual bool BeginSourceFileAction (clang::CompilerInstance &CI) override;
   virtual void EndSourceFileAction() override;
  private:
+  // append the replacements of the current file into the output file
+  void WriteReplacements();
+  // add the number of nodes found in the current file into the match counts
+  void WriteCounts();
+  // add the stats of the current file into the sample stats
+  void WriteStats();
+
   std::reference_wrapper<const std::string> mOutputFile;
-  clang::ast_matchers::MatchFinder mFinder;
-  clang::tooling::Replacements mReplacements;
-  std::vector<std::unique_ptr<MatchCallbackBase> > mCallbacks;
+  std::shared_ptr<CodeXformState> mState;
+  // memory reserved for the current file if not empty
+  std::string mAdmittedFile;
+  // when the current file started to be parsed
+  std::chrono::steady_clock::time_point mStartTime;
   static std::mutex mMutex;
 };
 
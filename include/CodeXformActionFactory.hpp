@@ -25,6 +25,9 @@
 #ifndef CODE_XFORM_ACTION_FACTORY_HPP
 #define CODE_XFORM_ACTION_FACTORY_HPP
 
+#include "CodeXformOptions.hpp"
+
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -35,22 +38,37 @@ namespace clang {
 class FrontendAction;
 } // end of namespace clang
 
+class CodeXformState;
+
+// The actions created by a factory run in sequence and share one CodeXformState,
+// so a factory must not be used by several threads at the same time.
 class CodeXformActionFactory : public clang::tooling::FrontendActionFactory {
  public:
   CodeXformActionFactory(const std::string& outputFile,
                          const std::vector<std::string>& matchers,
-                         const std::vector<std::string>& matcherArgs)
+                         const std::vector<std::string>& matcherArgs,
+                         const CodeXformOptions& options = CodeXformOptions())
       : mOutputFile(outputFile),
         mMatchers(matchers),
-        mMatcherArgs(matcherArgs)
+        mMatcherArgs(matcherArgs),
+        mOptions(options)
   {}
 
   clang::FrontendAction *create() override;
 
+  // skip the file without parsing it once the match limit is reached
+  bool runInvocation(std::shared_ptr<clang::CompilerInvocation> invocation,
+                     clang::FileManager* files,
+                     std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                     clang::DiagnosticConsumer* diagConsumer) override;
+
  private:
   std::reference_wrapper<const std::string> mOutputFile;
   std::reference_wrapper<const std::vector<std::string> > mMatchers;
   std::reference_wrapper<const std::vector<std::string> > mMatcherArgs;
+  CodeXformOptions mOptions;
+  // built by the first action
+  std::shared_ptr<CodeXformState> mState;
 };
 
 
@@ -66,6 +66,13 @@ class FileSystemException : public CodeXformSystemException {
   {}
 };
 
+class ServerException : public CodeXformSystemException {
+ public:
+  ServerException(const std::string& message)
+      : CodeXformSystemException(message)
+  {}
+};
+
 class ExecCmdException : public CodeXformSystemException {
  public:
   ExecCmdException(const std::string& cmd, const std::string& msg)
@@ -0,0 +1,72 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef CODE_XFORM_OPTIONS_HPP
+#define CODE_XFORM_OPTIONS_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+class FindIndex;
+class MatchCounts;
+class MatchLimit;
+class MemoryBudget;
+class SampleStats;
+
+// Options controlling how each translation unit is processed.
+struct CodeXformOptions
+{
+  CodeXformOptions() = default;
+
+  // only traverse the top-level declarations in the main file
+  bool mainFileScope = false;
+  // headers whose top-level declarations are traversed as well
+  std::vector<std::string> scopeHeaders;
+  // owning file of each header. declarations of an owned header are only
+  // traversed when processing its owner. not encoded by EncodeOptions
+  std::shared_ptr<const std::unordered_map<std::string, std::string> > headerOwners;
+  // admission control shared by all the threads. not encoded by EncodeOptions
+  std::shared_ptr<MemoryBudget> memoryBudget;
+  // file recording the nodes found instead of the replacements, shared by all
+  // the threads. not encoded by EncodeOptions
+  std::shared_ptr<FindIndex> findIndex;
+  // number of nodes found per matcher and file instead of the replacements,
+  // shared by all the threads. not encoded by EncodeOptions
+  std::shared_ptr<MatchCounts> matchCounts;
+  // stats of each file processed, shared by all the threads. not encoded by EncodeOptions
+  std::shared_ptr<SampleStats> sampleStats;
+  // limit on the nodes found by all the threads. not encoded by EncodeOptions
+  std::shared_ptr<MatchLimit> matchLimit;
+};
+
+// encode the options as a list of "key=value" strings
+std::vector<std::string> EncodeOptions(const CodeXformOptions& options);
+
+// decode the options encoded by EncodeOptions.
+// return false if any unknown option exists
+bool DecodeOptions(const std::vector<std::string>& fields, CodeXformOptions& options);
+
+#endif
@@ -56,6 +56,46 @@ struct CommandLineArgs
   bool version = false;
   // log file
   std::string logFile;
+  // generate compile commands for headers
+  bool genHeaderCompDB = false;
+  // cache directory
+  std::string cacheDir;
+  // list files including the given header
+  std::string listIncluders;
+  // list headers included by the given file
+  std::string listIncludes;
+  // only process files affected by changes since the last run
+  bool incremental = false;
+  // unix socket to serve requests on
+  std::string server;
+  // unix socket of the server to send requests to
+  std::string connect;
+  // re-run matchers when files are modified
+  bool watch = false;
+  // only traverse the top-level declarations in the main file
+  bool mainFileScope = false;
+  // headers whose top-level declarations are traversed as well
+  std::vector<std::string> scopeHeaders;
+  // only match each header when processing its owning file
+  bool headerOwnership = false;
+  // estimate the cost of a run without running matchers
+  bool preflight = false;
+  // memory used by the files processed concurrently, e.g. 16G
+  std::string memoryBudget;
+  // shared libraries registering more matchers
+  std::vector<std::string> loadMatchers;
+  // matcher expression in clang-query syntax to run
+  std::string query;
+  // record the nodes found into the given columnar file instead of replacements
+  std::string findIndex;
+  // print the hits of the given find index per matcher and directory
+  std::string indexCounts;
+  // only count the nodes found per matcher and file
+  bool countOnly = false;
+  // fraction of the files to process to estimate a full run, 0 for all the files
+  double sample = 0;
+  // stop once the given number of nodes are found, 0 for no limit
+  int maxMatches = 0;
 };
 
 // Parse the command line arguments.
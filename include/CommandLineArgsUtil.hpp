@@ -35,4 +35,9 @@ std::vector<std::string> StripMatcherArgs(int& argc, const char* const * argv);
 std::vector<std::vector<std::string> > GetMatcherArgs(const std::vector<std::string>& args,
                                                       const std::string& id);
 
+// Make the values of the given path options in the matcher arguments absolute,
+// e.g. before sending them to a server whose current directory differs
+std::vector<std::string> MakePathArgsAbsolute(std::vector<std::string> args,
+                                              const std::vector<std::string>& pathOptions);
+
 #endif
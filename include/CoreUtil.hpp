@@ -25,8 +25,14 @@
 #ifndef CORE_UTIL_HPP
 #define CORE_UTIL_HPP
 
+#include "CodeXformOptions.hpp"
+
 #include <string>
 #include <vector>
+#include <utility>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/Support/VirtualFileSystem.h"
 
 // convert a macro into a string
 #define STRINGIFY(x) #x
@@ -48,6 +54,13 @@ inline int ExecCmd(const std::string& cmd) {
   return ExecCmd(cmd, tmp);
 }
 
+// return the normalized absolute path of the file relative to the given directory
+std::string GetAbsolutePath(const std::string& dir, const std::string& file);
+
+// return the normalized absolute path of the file relative to the current directory.
+// paths compared with the include graph must be normalized by this function
+std::string GetNormalizedPath(const std::string& file);
+
 // parse config file and return string values for a given key
 // return true if succeed
 std::vector<std::string> ParseConfigFile(const std::string& fileName, const std::string& key);
@@ -55,11 +68,19 @@ std::vector<std::string> ParseConfigFile(const std::string& fileName, const std:
 // retrieve all matcher arguments from the given config file
 std::vector<std::string> ParseConfigFileForMatcherArgs(const std::string& fileName);
 
+// split the given number of files into the consecutive batches processed by one
+// thread each in ProcessFiles. return the [begin, end) range of each batch
+std::vector<std::pair<size_t, size_t> > PartitionFiles(size_t numFiles, unsigned int numThreads);
+
+// run the matchers over the given files in parallel. files are read through the
+// given file system, or a SharedFileCache created for this run if none is given
 int ProcessFiles(const clang::tooling::CompilationDatabase& compilationDatabase,
                  const std::vector<std::string>& inputFiles,
                  const std::string& outputFile,
                  const std::vector<std::string>& matchers,
                  const std::vector<std::string>& matcherArgs,
-                 unsigned int numThreads);
+                 unsigned int numThreads,
+                 const CodeXformOptions& options = CodeXformOptions(),
+                 llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> baseFS = nullptr);
 
 #endif
@@ -0,0 +1,56 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef DEPENDENCY_SCANNER_HPP
+#define DEPENDENCY_SCANNER_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "llvm/ADT/StringRef.h"
+
+// forward declarations
+namespace clang {
+namespace tooling {
+
+class CompilationDatabase;
+
+} // end namespace tooling
+} // end namespace clang
+
+// map from a source file to the headers it includes directly or transitively
+typedef std::map<std::string, std::vector<std::string> > DependencyMap;
+
+// parse the make-style dependency output generated by clang and
+// return the list of dependencies with the target stripped off
+std::vector<std::string> ParseDependencyFile(llvm::StringRef deps);
+
+// run clang's dependency scanner over the given files in parallel and
+// return the absolute paths of the headers included by each file
+DependencyMap ScanDependencies(const clang::tooling::CompilationDatabase& compilationDatabase,
+                               const std::vector<std::string>& inputFiles,
+                               unsigned int numThreads);
+
+#endif
@@ -0,0 +1,90 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include "CodeXformOptions.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// forward declarations
+namespace clang {
+namespace tooling {
+
+class CompilationDatabase;
+
+} // end namespace tooling
+} // end namespace clang
+
+// Watch files for modifications with inotify. The parent directories are
+// watched instead of the files so that editors replacing a file on save are
+// also noticed.
+class FileWatcher {
+ public:
+  FileWatcher();
+  ~FileWatcher();
+  FileWatcher(const FileWatcher&) = delete;
+  FileWatcher& operator=(const FileWatcher&) = delete;
+
+  // start watching the given file given by absolute path
+  void Watch(const std::string& file);
+
+  // return true if the given file is watched
+  bool IsWatched(const std::string& file) const;
+
+  // block until any watched file is modified and return the modified files.
+  // modifications within the given interval are reported together
+  std::vector<std::string> WaitForChanges(int intervalMs = 100);
+
+ private:
+  int mFD = -1;
+  // watched directories
+  std::unordered_map<int, std::string> mDirs;
+  std::unordered_map<std::string, int> mDirIDs;
+  std::unordered_set<std::string> mFiles;
+};
+
+// replace the replacements of the given processed files, keyed by their
+// normalized main file, by the ones read from the given yaml file
+void UpdateReplacementsByFile(std::map<std::string, std::string>& replacements,
+                              const std::vector<std::string>& files,
+                              const std::string& replacementsFile);
+
+// process the given files, then re-run the matchers over the files affected by
+// every modification and keep the output file up to date until interrupted
+void WatchFiles(const clang::tooling::CompilationDatabase& compilationDatabase,
+                const std::vector<std::string>& inputFiles,
+                const std::string& outputFile,
+                const std::vector<std::string>& matchers,
+                const std::vector<std::string>& matcherArgs,
+                unsigned int numThreads,
+                const std::string& cacheDir,
+                const CodeXformOptions& options = CodeXformOptions());
+
+#endif
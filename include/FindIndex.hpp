@@ -0,0 +1,133 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef FIND_INDEX_HPP
+#define FIND_INDEX_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Hits found in one translation unit, stored column by column. Matcher ids and
+// file names are interned into per-block tables, so that each hit only costs a
+// few integers besides its snippet.
+class FindIndexBlock {
+ public:
+  FindIndexBlock() = default;
+
+  void Add(const std::string& matcher, const std::string& file, uint32_t offset,
+           uint32_t line, uint32_t column, const std::string& snippet);
+
+  size_t size() const {
+    return mMatcherColumn.size();
+  }
+
+  bool empty() const {
+    return mMatcherColumn.empty();
+  }
+
+  void clear();
+
+ private:
+  friend class FindIndex;
+
+  static uint32_t Intern(const std::string& name, std::vector<std::string>& names,
+                         std::unordered_map<std::string, uint32_t>& ids);
+
+  std::vector<std::string> mMatchers;
+  std::unordered_map<std::string, uint32_t> mMatcherIDs;
+  std::vector<std::string> mFiles;
+  std::unordered_map<std::string, uint32_t> mFileIDs;
+  std::vector<uint32_t> mMatcherColumn;
+  std::vector<uint32_t> mFileColumn;
+  std::vector<uint32_t> mOffsetColumn;
+  std::vector<uint32_t> mLineColumn;
+  std::vector<uint32_t> mColumnColumn;
+  // end of the snippet of each hit in mSnippets
+  std::vector<uint32_t> mSnippetEnds;
+  std::string mSnippets;
+};
+
+// Columnar file storing the hits of a find-only run. Each thread fills its own
+// block and appends it once per translation unit, so that the writers only
+// contend for the time of a single write.
+class FindIndex {
+ public:
+  // create or truncate the given file.
+  // throw FileSystemException if it cannot be written
+  explicit FindIndex(const std::string& file);
+  FindIndex(const FindIndex&) = delete;
+  FindIndex& operator=(const FindIndex&) = delete;
+
+  // append the hits of the given block and clear it
+  void Append(FindIndexBlock& block);
+
+  // number of hits appended so far
+  uint64_t size() const {
+    return mSize;
+  }
+
+ private:
+  std::string mFile;
+  std::ofstream mOfs;
+  std::mutex mMutex;
+  std::atomic<uint64_t> mSize{0};
+};
+
+struct FindHit {
+  std::string matcher;
+  std::string file;
+  uint32_t offset = 0;
+  uint32_t line = 0;
+  uint32_t column = 0;
+  std::string snippet;
+};
+
+// call the given function for each hit of the given index file.
+// throw FileSystemException if the file cannot be read or has an unknown format
+void ReadFindIndex(const std::string& file, const std::function<void(const FindHit&)>& fn);
+
+// number of hits per matcher, per file and per directory of an index file
+struct FindIndexCounts {
+  uint64_t total = 0;
+  std::map<std::string, uint64_t> matchers;
+  std::map<std::string, uint64_t> files;
+  std::map<std::string, uint64_t> directories;
+};
+
+// count the hits of the given index file. Only the matcher and file columns are
+// read, the other columns and the snippets are skipped.
+// throw FileSystemException if the file cannot be read or has an unknown format
+FindIndexCounts CountFindIndex(const std::string& file);
+
+void PrintFindIndexCounts(const FindIndexCounts& counts, std::ostream& os);
+
+#endif
@@ -0,0 +1,58 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef HEADER_COMPDB_HPP
+#define HEADER_COMPDB_HPP
+
+#include "DependencyScanner.hpp"
+
+#include <string>
+#include <map>
+
+// forward declarations
+namespace clang {
+namespace tooling {
+
+class CompilationDatabase;
+
+} // end namespace tooling
+} // end namespace clang
+
+// return true if the file has a header extension
+bool IsHeaderFile(const std::string& file);
+
+// assign each header under the root directory to the source file whose compile
+// command fits it best, i.e. the source file with the same stem, or the closest
+// source file in the directory tree. Return a map from header to source file
+std::map<std::string, std::string> AssignHeadersToSources(const DependencyMap& dependencies,
+                                                          const std::string& rootDir);
+
+// generate compile commands for the headers included by the source files in the
+// given json compilation database and append them into the json file.
+// return the number of generated compile commands
+size_t GenerateHeaderCompDB(const std::string& jsonFile,
+                            const clang::tooling::CompilationDatabase& compilationDatabase,
+                            unsigned int numThreads);
+
+#endif
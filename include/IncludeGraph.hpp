@@ -0,0 +1,114 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef INCLUDE_GRAPH_HPP
+#define INCLUDE_GRAPH_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+// forward declarations
+namespace clang {
+namespace tooling {
+
+class CompilationDatabase;
+
+} // end namespace tooling
+} // end namespace clang
+
+// A persistent graph recording which headers are reached by each source file.
+// Source files are scanned by clang's dependency scanner and only rescanned
+// when the source file or any of its headers is modified after the last scan.
+class IncludeGraph {
+ public:
+  IncludeGraph() = default;
+
+  // read the graph from the given file.
+  // return false if the file does not exist or has an unknown format
+  bool Load(const std::string& file);
+
+  // write the graph into the given file
+  void Save(const std::string& file) const;
+
+  // rescan the given files which are new or modified since their last scan.
+  // return the number of rescanned files
+  size_t Update(const clang::tooling::CompilationDatabase& compilationDatabase,
+                const std::vector<std::string>& files,
+                unsigned int numThreads);
+
+  // record the headers reached by the given file scanned at the given time
+  void SetIncludedHeaders(const std::string& file,
+                          const std::vector<std::string>& headers,
+                          int64_t timestamp);
+
+  // return true if the given file has been scanned
+  bool HasFile(const std::string& file) const;
+
+  // list all the scanned files
+  std::vector<std::string> GetFiles() const;
+
+  // list the headers reached by the given file
+  std::vector<std::string> GetIncludedHeaders(const std::string& file) const;
+
+  // list the scanned files reaching the given header
+  std::vector<std::string> GetIncludingFiles(const std::string& header) const;
+
+ private:
+  struct Entry {
+    int64_t timestamp = 0;
+    std::vector<unsigned> headers;
+  };
+
+  unsigned GetPathID(const std::string& path);
+  std::vector<std::string> GetPaths(const std::vector<unsigned>& ids) const;
+
+  // interned file paths
+  std::vector<std::string> mPaths;
+  std::unordered_map<std::string, unsigned> mPathIDs;
+  // scanned files and the headers they reach
+  std::map<unsigned, Entry> mEntries;
+  // reverse index from header to the scanned files reaching it
+  std::unordered_map<unsigned, std::set<unsigned> > mIncluders;
+};
+
+// path of the include graph file stored in the given cache directory
+std::string GetIncludeGraphFile(const std::string& cacheDir);
+
+// load the include graph from the given cache directory, bring it up to date
+// for the given files and store it back
+IncludeGraph LoadIncludeGraph(const std::string& cacheDir,
+                              const clang::tooling::CompilationDatabase& compilationDatabase,
+                              const std::vector<std::string>& files,
+                              unsigned int numThreads);
+
+// assign each header reached by the given files to exactly one of them, the
+// one reaching the fewest headers. return the owning file of each header
+std::unordered_map<std::string, std::string>
+GetHeaderOwners(const IncludeGraph& graph, const std::vector<std::string>& files);
+
+#endif
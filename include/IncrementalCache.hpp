@@ -0,0 +1,128 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef INCREMENTAL_CACHE_HPP
+#define INCREMENTAL_CACHE_HPP
+
+#include "CodeXformOptions.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+
+// forward declarations
+namespace clang {
+namespace tooling {
+
+class CompilationDatabase;
+
+} // end namespace tooling
+} // end namespace clang
+
+class IncludeGraph;
+
+// Manifest of a run recording the signature of the matchers, the compile
+// command of each processed file and the content hash of every file read.
+class RunManifest {
+ public:
+  RunManifest() = default;
+
+  // read the manifest from the given file.
+  // return false if the file does not exist or has an unknown format
+  bool Load(const std::string& file);
+
+  // write the manifest into the given file
+  void Save(const std::string& file) const;
+
+  const std::string& GetSignature() const { return mSignature; }
+  void SetSignature(const std::string& signature) { mSignature = signature; }
+
+  // return the content hash of the given file, empty if unknown
+  std::string GetFileHash(const std::string& file) const;
+  void SetFileHash(const std::string& file, const std::string& hash);
+
+  // return the compile command hash of the given processed file, empty if unknown
+  std::string GetCommandHash(const std::string& file) const;
+  void SetCommandHash(const std::string& file, const std::string& hash);
+
+  // add the entries of the previous manifest which are not recorded by this
+  // one. nothing is added if the signatures differ. the processed files of the
+  // previous manifest reaching a file hashed differently by this one, per the
+  // given include graph, are dropped and returned, since their cached
+  // replacements are stale
+  std::vector<std::string> Merge(const RunManifest& previous, const IncludeGraph& graph);
+
+ private:
+  std::string mSignature;
+  std::map<std::string, std::string> mFileHashes;
+  std::map<std::string, std::string> mCommandHashes;
+};
+
+// return the MD5 hash of the content of the given file, empty if unreadable
+std::string HashFile(const std::string& file);
+
+// hash the given files in parallel
+std::vector<std::string> HashFiles(const std::vector<std::string>& files,
+                                   unsigned int numThreads);
+
+// return the hash of the compile command of the given file, empty if unknown
+std::string HashCompileCommand(const clang::tooling::CompilationDatabase& compilationDatabase,
+                               const std::string& file);
+
+// return the signature of a run with the given matchers and their arguments.
+// the signature changes whenever the executable is rebuilt
+std::string GetRunSignature(const std::vector<std::string>& matchers,
+                            const std::vector<std::string>& matcherArgs,
+                            const CodeXformOptions& options = CodeXformOptions());
+
+// select the files whose transitive inputs changed since the previous run
+std::vector<std::string> SelectAffectedFiles(const RunManifest& previous,
+                                             const RunManifest& current,
+                                             const IncludeGraph& graph,
+                                             const std::vector<std::string>& files);
+
+// read the replacements stored in the given yaml file. return the yaml
+// document of each main source file
+std::map<std::string, std::string> ReadReplacementsByFile(const std::string& file);
+
+// path of the manifest file stored in the given cache directory
+std::string GetManifestFile(const std::string& cacheDir);
+
+// path of the replacement file stored in the given cache directory
+std::string GetCachedReplacementsFile(const std::string& cacheDir);
+
+// process only the files affected by changes since the previous run and
+// append the cached replacements of the other files into the output file.
+// the replacements are not applied since the cache records the sources
+// before any replacement
+int ProcessFilesIncrementally(const clang::tooling::CompilationDatabase& compilationDatabase,
+                              const std::vector<std::string>& inputFiles,
+                              const std::string& outputFile,
+                              const std::vector<std::string>& matchers,
+                              const std::vector<std::string>& matcherArgs,
+                              unsigned int numThreads,
+                              const std::string& cacheDir,
+                              const CodeXformOptions& options = CodeXformOptions());
+
+#endif
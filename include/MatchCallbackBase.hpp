@@ -28,18 +28,72 @@
 #include "cxxopts.hpp"
 #include "CodeXformException.hpp"
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/Basic/SourceLocation.h"
 #include "clang/Tooling/Core/Replacement.h"
+#include "llvm/ADT/DenseMap.h"
+
+// forward declaration
+class FindIndexBlock;
+class MatchLimit;
+class VisitorDispatcher;
+
+// Immutable table of the parsed option values of a matcher instance. It is
+// built once for each distinct set of matcher arguments and shared by the
+// instances created by all the threads.
+class MatcherOptionTable {
+ public:
+  template <typename T>
+  void Set(const std::string& key, T value) {
+    mValues[key] = Value{TypeTag<T>(), std::make_shared<const T>(std::move(value))};
+  }
+
+  template <typename T>
+  const T& Get(const std::string& key) const {
+    auto iter = mValues.find(key);
+    if (iter == mValues.end()) {
+      throw cxxopts::option_not_present_exception(key);
+    }
+    if (iter->second.type != TypeTag<T>()) {
+      throw CommandLineOptionException("Option " + key + " is read with a type other than its registered type");
+    }
+    return *static_cast<const T*>(iter->second.value.get());
+  }
+
+  bool Has(const std::string& key) const {
+    return mValues.count(key) != 0;
+  }
+
+  // unique address per type, used in place of RTTI
+  template <typename T>
+  static const void* TypeTag() {
+    static const char tag = 0;
+    return &tag;
+  }
+
+ private:
+  struct Value {
+    const void* type;
+    std::shared_ptr<const void> value;
+  };
+  std::unordered_map<std::string, Value> mValues;
+};
 
 class MatchCallbackBase : public clang::ast_matchers::MatchFinder::MatchCallback {
  public :
   explicit MatchCallbackBase(const std::string& id,
                              clang::tooling::Replacements& replacements,
                              std::vector<std::string> args)
-      : mOptions(id), mReplacements(replacements), mArgs(std::move(args))
+      : mId(id), mOptions(id), mReplacements(replacements), mArgs(std::move(args))
   {
     if (!mArgs.empty() && (("--matcher-args-" + id) != mArgs[0])) {
       throw CommandLineOptionException("Cannot find matcher arguments separator --matcher-args-" + id);
@@ -49,10 +103,16 @@ class MatchCallbackBase : public clang::ast_matchers::MatchFinder::MatchCallback
   virtual ~MatchCallbackBase() {}
 
   llvm::Error AddReplacement(const clang::tooling::Replacement& R) {
+    if (!AdmitMatch()) {
+      return llvm::Error::success();
+    }
     return mReplacements.get().add(R);
   }
 
   void MergeReplacement(const clang::tooling::Replacement& R) {
+    if (!AdmitMatch()) {
+      return;
+    }
     mReplacements.get() = mReplacements.get().merge(clang::tooling::Replacements(R));
   }
 
@@ -61,6 +121,9 @@ class MatchCallbackBase : public clang::ast_matchers::MatchFinder::MatchCallback
    */
   void InsertText(const clang::SourceManager &Sources, clang::SourceLocation Start,
                   llvm::StringRef NewStr) {
+    if (mCountOnly || !AdmitMatch()) {
+      return;
+    }
     return MergeReplacement(clang::tooling::Replacement(Sources,
                                                         Start,
                                                         0,
@@ -85,6 +148,9 @@ class MatchCallbackBase : public clang::ast_matchers::MatchFinder::MatchCallback
    */
   llvm::Error ReplaceText (const clang::SourceManager &Sources, clang::SourceLocation Start,
                            unsigned OrigLength, llvm::StringRef NewStr) {
+    if (mCountOnly || !AdmitMatch()) {
+      return llvm::Error::success();
+    }
     return AddReplacement(clang::tooling::Replacement(Sources,
                                                       Start,
                                                       OrigLength,
@@ -94,6 +160,9 @@ class MatchCallbackBase : public clang::ast_matchers::MatchFinder::MatchCallback
                            clang::SourceRange range,
                            llvm::StringRef NewStr,
                            const clang::LangOptions &LangOpts=clang::LangOptions()) {
+    if (mCountOnly || !AdmitMatch()) {
+      return llvm::Error::success();
+    }
     return AddReplacement(clang::tooling::Replacement(Sources,
                                                       clang::CharSourceRange::getTokenRange(range),
                                                       NewStr,
@@ -106,17 +175,77 @@ class MatchCallbackBase : public clang::ast_matchers::MatchFinder::MatchCallback
     // default do nothing
   }
 
-  virtual void ParseOptions() {
-    if (!mArgs.empty()) {
-      int argc = static_cast<int>(mArgs.size());
-      std::vector<char*> cstrArgs;
-      cstrArgs.reserve(argc);
-      for (auto& s : mArgs) {
-        cstrArgs.push_back(const_cast<char*>(s.c_str()));
-      }
-      char** argv = &cstrArgs[0];
-      mResult = std::make_unique<cxxopts::ParseResult>(mOptions.parse(argc, argv));
-    }
+  // register the node kinds visited by the callback, see VisitorCallbackBase
+  virtual void RegisterVisitors(VisitorDispatcher* dispatcher) {
+    // default do nothing
+  }
+
+  // identifiers, one of which appears in the text of the main file of each
+  // match, used to process the files likely to match first. empty if unknown
+  virtual std::vector<std::string> GetPrefilterTokens() const {
+    return std::vector<std::string>();
+  }
+
+  // return true if the callback visits nodes instead of registering matchers
+  virtual bool IsVisitorCallback() const {
+    return false;
+  }
+
+  // parse the matcher arguments into the option table. The table is shared
+  // with the instances previously parsed from the same arguments and options
+  virtual void ParseOptions();
+
+  // release the state kept for the current translation unit.
+  // called after each translation unit
+  virtual void Reset() {
+    // default do nothing
+  }
+
+  // return true if the matchers only match nodes expanded in the main file,
+  // in which case function bodies outside the main file are not parsed
+  bool IsMainFileOnly() const {
+    return mMainFileOnly;
+  }
+
+  // record the nodes logged by LogASTNode and LogReplacement into the given
+  // block instead of the log, see --find-index
+  void SetFindIndex(FindIndexBlock* findHits) {
+    mFindHits = findHits;
+  }
+
+  // count the nodes logged by LogASTNode and LogReplacement per file instead
+  // of logging them, and do not build replacements, see --count-only
+  void SetCountOnly(bool countOnly = true) {
+    mCountOnly = countOnly;
+  }
+
+  // take the number of nodes counted per file in the current translation unit
+  llvm::DenseMap<clang::FileID, uint64_t> TakeCounts() {
+    return std::move(mCounts);
+  }
+
+  // only edit and log the matches found within the given limit shared by all
+  // the threads, see --max-matches. A match is counted by its first replacement
+  // or log, and ends with its LogASTNode or LogReplacement
+  void SetMatchLimit(MatchLimit* matchLimit) {
+    mMatchLimit = matchLimit;
+  }
+
+  // close the current match, so that the next edit or log starts a new one.
+  // called after each translation unit
+  void EndMatch() {
+    mInMatch = false;
+    mMatchAdmitted = true;
+  }
+
+  // take the number of nodes logged by LogASTNode and LogReplacement in the
+  // current translation unit
+  uint64_t TakeNumNodes() {
+    return std::exchange(mNumNodes, 0);
+  }
+
+  const std::string& GetId() const {
+    return mId;
   }
 
   // register options and matchers
@@ -133,26 +262,119 @@ class MatchCallbackBase : public clang::ast_matchers::MatchFinder::MatchCallback
   template <typename T>
   void AddOption(const std::string& key) {
     mOptions.add_options()(key, "", cxxopts::value<T>());
+    mExtractors.push_back({key, MatcherOptionTable::TypeTag<T>(), &ExtractOption<T>});
   }
 
   template <typename T>
   void AddOption(const std::string& key, const std::string& value) {
     mOptions.add_options()(key, "", cxxopts::value<T>()->default_value(value));
+    mExtractors.push_back({key, MatcherOptionTable::TypeTag<T>(), &ExtractOption<T>});
   }
 
   template <typename T>
-  T GetOption(const std::string& key) const {
-    assert(mResult != nullptr);
-    return (*mResult.get())[key].as<T>();
+  const T& GetOption(const std::string& key) const {
+    assert(mTable != nullptr);
+    return mTable->Get<T>(key);
+  }
+
+  // return true if the option is given or has a default value
+  bool HasOption(const std::string& key) const {
+    return mTable != nullptr && mTable->Has(key);
+  }
+
+  // return true if the nodes found are recorded into the find index
+  bool IsFindOnly() const {
+    return mFindHits != nullptr;
+  }
+
+  // return true if the nodes found are only counted
+  bool IsCountOnly() const {
+    return mCountOnly;
+  }
+
+  // source text of the given token range, empty with --count-only.
+  // hides the free function of ToolingUtil.hpp in the callbacks
+  std::string getSourceText(clang::SourceLocation start, clang::SourceLocation end,
+                            const clang::SourceManager& sm,
+                            const clang::LangOptions& langOpts) const;
+
+  // log a node found, or record it into the find index with its source text.
+  // hides the free function of ToolingUtil.hpp in the callbacks
+  void LogASTNode(clang::SourceLocation loc, const clang::SourceManager& sm,
+                  const std::string& expr);
+
+  // log a replacement, or record its location and old text into the find index.
+  // hides the free function of ToolingUtil.hpp in the callbacks
+  void LogReplacement(clang::SourceLocation loc, const clang::SourceManager& sm,
+                      const std::string& oldExpr, const std::string& newExpr);
+
+  // end the current match with the node found, and return false if the match
+  // is beyond --max-matches. Called by LogASTNode and LogReplacement, and by
+  // the callbacks reporting their nodes by other means, e.g. --query
+  bool AdmitNode();
+
+  // declare that all the matchers use isExpansionInMainFile()
+  void SetMainFileOnly(bool mainFileOnly = true) {
+    mMainFileOnly = mainFileOnly;
   }
 
  private:
+  struct OptionExtractor {
+    std::string key;
+    const void* type;
+    void (*extract)(const cxxopts::ParseResult&, const std::string&, MatcherOptionTable&);
+  };
+
+  template <typename T>
+  static void ExtractOption(const cxxopts::ParseResult& result, const std::string& key,
+                            MatcherOptionTable& table) {
+    try {
+      table.Set<T>(key, result[key].as<T>());
+    } catch (std::domain_error&) {
+      // option without default value is not given
+    }
+  }
+
+  // count the current match against mMatchLimit once, and return false if
+  // it is beyond the limit, in which case it is neither edited nor logged
+  bool AdmitMatch();
+
+  // record the node of the given location into mFindHits
+  void AddFindHit(clang::SourceLocation loc, const clang::SourceManager& sm,
+                  const std::string& expr);
+
+  std::string mId;
   cxxopts::Options mOptions;
-  // initialization of cxxopts::ParseResult needs to be delayed.
-  // Use heap memory for now. May switch to std::optional if c++17 is supported
-  std::unique_ptr<cxxopts::ParseResult> mResult;
+  std::vector<OptionExtractor> mExtractors;
+  std::shared_ptr<const MatcherOptionTable> mTable;
   std::reference_wrapper<clang::tooling::Replacements> mReplacements;
   std::vector<std::string> mArgs;
+  bool mMainFileOnly = false;
+  FindIndexBlock* mFindHits = nullptr;
+  bool mCountOnly = false;
+  llvm::DenseMap<clang::FileID, uint64_t> mCounts;
+  uint64_t mNumNodes = 0;
+  MatchLimit* mMatchLimit = nullptr;
+  bool mInMatch = false;
+  bool mMatchAdmitted = true;
 };
 
+// Parse the arguments of all the instances of the given matchers once, so that
+// invalid arguments are reported before any file is processed and the option
+// tables are shared by the instances created later by each thread.
+// Throw CommandLineOptionException or cxxopts::OptionException on invalid arguments
+void ParseMatcherOptions(const std::vector<std::string>& ids,
+                         const std::vector<std::string>& args);
+
+// drop the option tables parsed so far. the instances still alive keep their
+// tables, so this can be called once a run is done
+void ClearMatcherOptions();
+
+// collect the prefilter tokens of all the instances of the given matchers,
+// whose arguments are checked by ParseMatcherOptions beforehand.
+// return false if the tokens of any instance are unknown
+bool GetPrefilterTokens(const std::vector<std::string>& ids,
+                        const std::vector<std::string>& args,
+                        std::vector<std::string>& tokens);
+
 #endif
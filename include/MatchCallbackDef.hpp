@@ -26,6 +26,7 @@ SOFTWARE.
 #define MATCH_CALLBACK_DEF_HPP
 
 #include "MatchCallbackBase.hpp"
+#include "VisitorCallbackBase.hpp"
 
 #define MATCH_CALLBACK(NAME)                                                                \
 class NAME : public MatchCallbackBase {                                                     \
@@ -52,5 +53,30 @@ class NAME : public MatchCallbackBase {
     virtual void RegisterOptions() override;                                                \
 }
 
+#define VISITOR_CALLBACK(NAME)                                                              \
+class NAME : public VisitorCallbackBase {                                                   \
+  public :                                                                                  \
+    explicit NAME (const std::string& id,                                                   \
+                   clang::tooling::Replacements& replacements,                              \
+                   std::vector<std::string> args)                                           \
+        : VisitorCallbackBase(id, replacements, std::move(args))                            \
+    {}                                                                                      \
+    virtual void RegisterVisitors(VisitorDispatcher* dispatcher) override;                  \
+    virtual void VisitStmt(const clang::Stmt* stmt, clang::ASTContext& context) override;   \
+}
+
+#define OPTION_VISITOR_CALLBACK(NAME)                                                       \
+class NAME : public VisitorCallbackBase {                                                   \
+  public :                                                                                  \
+    explicit NAME (const std::string& id,                                                   \
+                   clang::tooling::Replacements& replacements,                              \
+                   std::vector<std::string> args)                                           \
+        : VisitorCallbackBase(id, replacements, std::move(args))                            \
+    {}                                                                                      \
+    virtual void RegisterVisitors(VisitorDispatcher* dispatcher) override;                  \
+    virtual void VisitStmt(const clang::Stmt* stmt, clang::ASTContext& context) override;   \
+    virtual void RegisterOptions() override;                                                \
+}
+
 
 #endif
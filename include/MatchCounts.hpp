@@ -0,0 +1,67 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef MATCH_COUNTS_HPP
+#define MATCH_COUNTS_HPP
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+// Number of nodes found per matcher and per file by a --count-only run,
+// shared by all the threads. Each thread adds the counts of a translation unit
+// once it is processed.
+class MatchCounts {
+ public:
+  MatchCounts() = default;
+  MatchCounts(const MatchCounts&) = delete;
+  MatchCounts& operator=(const MatchCounts&) = delete;
+
+  void Add(const std::string& matcher, const std::string& file, uint64_t count);
+
+  // the getters must not be called while other threads add counts
+  uint64_t total() const {
+    return mTotal;
+  }
+
+  const std::map<std::string, uint64_t>& matchers() const {
+    return mMatchers;
+  }
+
+  const std::map<std::string, uint64_t>& files() const {
+    return mFiles;
+  }
+
+ private:
+  std::mutex mMutex;
+  uint64_t mTotal = 0;
+  std::map<std::string, uint64_t> mMatchers;
+  std::map<std::string, uint64_t> mFiles;
+};
+
+void PrintMatchCounts(const MatchCounts& counts, std::ostream& os);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef MATCH_LIMIT_HPP
+#define MATCH_LIMIT_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+// Limit on the number of nodes found by all the threads, see --max-matches.
+// Once it is reached, the files not parsed yet are skipped and the files being
+// parsed stop as soon as possible
+class MatchLimit {
+ public:
+  explicit MatchLimit(uint64_t maxMatches)
+      : mMaxMatches(maxMatches)
+  {}
+
+  // count a node found. return false if the limit was already reached
+  bool Add() {
+    return mCount.fetch_add(1, std::memory_order_relaxed) < mMaxMatches;
+  }
+
+  bool Reached() const {
+    return mCount.load(std::memory_order_relaxed) >= mMaxMatches;
+  }
+
+  // number of nodes counted within the limit
+  uint64_t count() const {
+    return std::min(mCount.load(std::memory_order_relaxed), mMaxMatches);
+  }
+
+ private:
+  const uint64_t mMaxMatches;
+  std::atomic<uint64_t> mCount{0};
+};
+
+#endif
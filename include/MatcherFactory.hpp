@@ -54,9 +54,13 @@ class MatcherFactory {
     return factory;
   }
     
+  // the first matcher registered with an ID is kept. the IDs registered again
+  // by a plugin being loaded are reported by LoadPlugin
   void RegisterMatchCallback(const std::string& id,
                              CreateCallbackFunction fcn) {
-    matcher_map_.emplace(id, fcn);
+    if (!matcher_map_.emplace(id, fcn).second && loading_plugin_) {
+      duplicate_ids_.push_back(id);
+    }
   }
     
   std::unique_ptr<MatchCallbackBase>
@@ -75,9 +79,23 @@ class MatcherFactory {
     return matcher_map_;
   }
 
+  // load a shared library whose MatcherHelper objects register matchers.
+  // throw FileSystemException if it cannot be loaded and
+  // CommandLineOptionException if it registers no new matcher or an ID
+  // already registered
+  void LoadPlugin(const std::string& path);
+
+  // plugins loaded so far
+  const std::vector<std::string>& getPlugins() const {
+    return plugins_;
+  }
+
  private:
   MatcherFactory() = default;
   MatcherMap matcher_map_;
+  std::vector<std::string> plugins_;
+  bool loading_plugin_ = false;
+  std::vector<std::string> duplicate_ids_;
 };
 
 #endif
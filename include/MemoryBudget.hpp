@@ -0,0 +1,98 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef MEMORY_BUDGET_HPP
+#define MEMORY_BUDGET_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// return the resident set size of the current process in bytes, 0 if unknown
+uint64_t GetCurrentRSS();
+
+// return the heap memory freed by the process to the system if supported
+void ReleaseFreeMemory();
+
+// parse a memory size such as "512M" or "16G" into bytes.
+// return false if the size is malformed
+bool ParseMemorySize(const std::string& size, uint64_t& bytes);
+
+// A thread-safe admission control limiting the memory used by the translation
+// units processed concurrently. The peak memory of each translation unit is
+// predicted from the previous runs, and a translation unit is only admitted
+// while the predicted memory of the translation units in flight and the
+// resident set size of the process both leave room for it. A translation unit
+// is always admitted when nothing else is in flight so that the run never stalls.
+class MemoryBudget {
+ public:
+  // the given default estimate is used for files without history
+  explicit MemoryBudget(uint64_t budget, uint64_t defaultEstimate = 0);
+
+  // read the recorded peaks from the given file.
+  // return false if the file does not exist or has an unknown format
+  bool Load(const std::string& file);
+
+  // write the recorded peaks into the given file
+  void Save(const std::string& file) const;
+
+  // predicted peak memory of the given file
+  uint64_t GetEstimate(const std::string& file) const;
+
+  // block until the given file fits into the budget and reserve its estimate
+  void Acquire(const std::string& file);
+
+  // release the reservation of the given file and record its measured peak
+  void Release(const std::string& file, uint64_t peak);
+
+  uint64_t GetBudget() const { return mBudget; }
+
+  // memory reserved by the files in flight
+  uint64_t GetReserved() const;
+
+ private:
+  uint64_t GetEstimateLocked(const std::string& file) const;
+
+  const uint64_t mBudget;
+  const uint64_t mDefaultEstimate;
+  // resident set size when the budget is created
+  const uint64_t mBaseline;
+  mutable std::mutex mMutex;
+  std::condition_variable mCondition;
+  // total estimate of the files in flight
+  uint64_t mReserved = 0;
+  // estimates reserved by each file in flight. a file compiled with several
+  // commands may be in flight more than once
+  std::unordered_map<std::string, std::vector<uint64_t> > mInFlight;
+  // recorded peak of each file
+  std::unordered_map<std::string, uint64_t> mPeaks;
+};
+
+// path of the memory history file stored in the given cache directory
+std::string GetMemoryHistoryFile(const std::string& cacheDir);
+
+#endif
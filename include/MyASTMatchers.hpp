@@ -25,7 +25,20 @@
 #ifndef MY_AST_MATCHERS_HPP
 #define MY_AST_MATCHERS_HPP
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/AST/DeclTemplate.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
 
 // self-defined AST Matchers and
 
@@ -37,167 +50,381 @@ AST_MATCHER(QualType, isRealFloating) {
   return Node->isRealFloatingType();
 }
 
+// map from declaration names, written as for hasName(), to values. A name
+// can be unqualified, partially qualified, or fully qualified with a leading
+// "::". As with hasName(), inline and anonymous namespaces may be omitted.
+// The name of a class template matches all its specializations, and a name
+// spelled with template arguments only the matching one. Declarations are
+// looked up by their unqualified name with one hash lookup, then their
+// scopes are compared one DeclContext at a time
+class QualifiedNameMap {
+ public:
+  void insert(const std::string& name, std::string value) {
+    Entry entry;
+    llvm::StringRef rest(name);
+    entry.fullyQualified = rest.consume_front("::");
+    llvm::SmallVector<llvm::StringRef, 4> components;
+    rest.split(components, "::");
+    std::string unqualified = components.pop_back_val().str();
+    for (const auto& component : components) {
+      entry.scopes.push_back(component.str());
+    }
+    entry.value = std::move(value);
+
+    auto& entries = mEntries[unqualified];
+    for (auto& existing : entries) {
+      if (existing.fullyQualified == entry.fullyQualified && existing.scopes == entry.scopes) {
+        existing.value = std::move(entry.value);
+        return;
+      }
+    }
+    // the most qualified names are tried first
+    auto pos = std::find_if(entries.begin(), entries.end(), [&entry](const Entry& existing) {
+        return std::make_pair(existing.fullyQualified, existing.scopes.size()) <
+            std::make_pair(entry.fullyQualified, entry.scopes.size());
+      });
+    entries.insert(pos, std::move(entry));
+    ++mSize;
+  }
+
+  size_t size() const {
+    return mSize;
+  }
+
+  // unqualified names of the declarations in the map
+  std::vector<std::string> getUnqualifiedNames() const {
+    std::vector<std::string> names;
+    for (const auto& entry : mEntries) {
+      names.push_back(entry.getKey().str());
+    }
+    return names;
+  }
+
+  // return the value of the declaration, or nullptr if its name is not in the map
+  const std::string* lookup(const NamedDecl& decl) const {
+    // reject most declarations on the unqualified name
+    auto iter = decl.getIdentifier() ? mEntries.find(decl.getIdentifier()->getName())
+                                     : mEntries.find(decl.getNameAsString());
+    if (iter == mEntries.end()) return nullptr;
+    for (const auto& entry : iter->second) {
+      if (matchesScopes(decl, entry)) return &entry.value;
+    }
+    return nullptr;
+  }
+
+ private:
+  struct Entry {
+    bool fullyQualified = false;
+    // enclosing scopes from the outermost
+    std::vector<std::string> scopes;
+    std::string value;
+  };
+
+  static bool matchesRecord(const RecordDecl& record, llvm::StringRef name) {
+    if (record.getName() == name) return true;
+    const auto* specialization = llvm::dyn_cast<ClassTemplateSpecializationDecl>(&record);
+    if (!specialization || name.find('<') == llvm::StringRef::npos) return false;
+    std::string printed;
+    llvm::raw_string_ostream OS(printed);
+    specialization->getNameForDiagnostic(OS, specialization->getASTContext().getPrintingPolicy(),
+                                         false);
+    return OS.str() == name;
+  }
+
+  static bool matchesScopes(const NamedDecl& decl, const Entry& entry) {
+    // number of scopes of the entry left to match, the innermost last
+    size_t remaining = entry.scopes.size();
+    for (const DeclContext* ctx = decl.getDeclContext(); ctx && !ctx->isTranslationUnit();
+         ctx = ctx->getParent()) {
+      if (ctx->isFunctionOrMethod()) {
+        // local declarations only match names relative to the function
+        return remaining == 0 && !entry.fullyQualified;
+      }
+      if (remaining == 0 && !entry.fullyQualified) return true;
+      llvm::StringRef scope = remaining ? llvm::StringRef(entry.scopes[remaining - 1]) : "";
+      if (const auto* ns = llvm::dyn_cast<NamespaceDecl>(ctx)) {
+        bool anonymous = ns->isAnonymousNamespace();
+        if (remaining && scope == (anonymous ? "(anonymous namespace)" : ns->getName())) {
+          --remaining;
+        } else if (!anonymous && !ns->isInline()) {
+          return false;
+        }
+      } else if (const auto* record = llvm::dyn_cast<RecordDecl>(ctx)) {
+        if (!remaining || !matchesRecord(*record, scope)) return false;
+        --remaining;
+      } else if (const auto* named = llvm::dyn_cast<NamedDecl>(ctx)) {
+        if (!remaining || scope != named->getNameAsString()) return false;
+        --remaining;
+      }
+      // other contexts such as extern "C" blocks are transparent
+    }
+    return remaining == 0;
+  }
+
+  // entries of each unqualified name
+  llvm::StringMap<std::vector<Entry> > mEntries;
+  size_t mSize = 0;
+};
+
+// match if the name of the declaration is in the given map
+AST_MATCHER_P(NamedDecl, hasNameIn, std::shared_ptr<const QualifiedNameMap>, names) {
+  return names->lookup(Node) != nullptr;
+}
+
 AST_MATCHER(BinaryOperator, isComparisonOperator) {
   return Node.isComparisonOp();
 }
 
-AST_MATCHER(CallExpr, hasSLSizeCmpDecl) {
-  if (auto decl = Node.getDirectCallee()) {
-    std::string name = decl->getNameAsString();
-    if (name == "DimEqualTo" ||
-        name == "DimNotEqual" ||
-        name == "DimLess" ||
-        name == "DimLessEqual" ||
-        name == "DimGreater" ||
-        name == "DimGreaterEqual") {
+// Identifiers and types used by the SLSize matchers below. They are resolved
+// once per ASTContext, so the matchers compare pointers instead of building
+// and comparing names for every node. The classification of expressions is
+// memoized for the lifetime of the ASTContext, i.e. the translation unit
+class SLSizeClassifier {
+ public:
+  explicit SLSizeClassifier(ASTContext& ctx)
+      : mIntType(ctx.IntTy.getTypePtr()),
+        mSLSize(&ctx.Idents.get("SLSize")),
+        mSLIndex(&ctx.Idents.get("SLIndex")),
+        mSizeT(&ctx.Idents.get("size_t")),
+        mStd(&ctx.Idents.get("std")),
+        mVector(&ctx.Idents.get("vector")),
+        mMax(&ctx.Idents.get("max")),
+        mMin(&ctx.Idents.get("min")),
+        mCmpDecls{&ctx.Idents.get("DimEqualTo"),
+                  &ctx.Idents.get("DimNotEqual"),
+                  &ctx.Idents.get("DimLess"),
+                  &ctx.Idents.get("DimLessEqual"),
+                  &ctx.Idents.get("DimGreater"),
+                  &ctx.Idents.get("DimGreaterEqual")},
+        mCastDecls{&ctx.Idents.get("DimValue2Int"),
+                   &ctx.Idents.get("DimValue2Sizet"),
+                   &ctx.Idents.get("DimValue2SLSize")}
+  {}
+
+  // return the classifier of the given ASTContext, created on first use and
+  // destroyed with the ASTContext
+  static SLSizeClassifier& get(ASTContext& ctx) {
+    thread_local llvm::DenseMap<const ASTContext*, std::unique_ptr<SLSizeClassifier> > classifiers;
+    auto& classifier = classifiers[&ctx];
+    if (!classifier) {
+      classifier = std::make_unique<SLSizeClassifier>(ctx);
+      ctx.AddDeallocation([](void* data) {
+          classifiers.erase(static_cast<const ASTContext*>(data));
+        }, &ctx);
+    }
+    return *classifier;
+  }
+
+  bool isSLSizeCmpDecl(const FunctionDecl* decl) const {
+    const IdentifierInfo* id = decl->getIdentifier();
+    return id && std::find(std::begin(mCmpDecls), std::end(mCmpDecls), id) != std::end(mCmpDecls);
+  }
+
+  bool isSLSizeCastDecl(const FunctionDecl* decl) const {
+    const IdentifierInfo* id = decl->getIdentifier();
+    return id && std::find(std::begin(mCastDecls), std::end(mCastDecls), id) != std::end(mCastDecls);
+  }
+
+  // type spelled SLSize or SLIndex
+  bool isSLSizeType(QualType type) const {
+    const IdentifierInfo* id = getTypedefName(type);
+    return id && (id == mSLSize || id == mSLIndex);
+  }
+
+  // SLSize type variable, or value returned by vector<SLSize> index operator
+  bool isBasicSLSizeExpr(const Expr& expr) const {
+    auto inserted = mBasicSLSizeExprs.try_emplace(&expr, false);
+    if (inserted.second) {
+      inserted.first->second = classifyBasicSLSizeExpr(expr);
+    }
+    return inserted.first->second;
+  }
+
+  // arithmetic expression resulting in SLSize
+  bool isArithmeticOperatorWithSLSize(const Expr& expr) const {
+    if (const auto* binaryOperator = llvm::dyn_cast<BinaryOperator>(&expr)) {
+      if (binaryOperator->isAdditiveOp() ||
+          binaryOperator->isMultiplicativeOp() ||
+          binaryOperator->isShiftOp()) {
+        if (isBasicSLSizeExpr(*binaryOperator->getLHS()->IgnoreParenImpCasts()) ||
+            isBasicSLSizeExpr(*binaryOperator->getRHS()->IgnoreParenImpCasts())) {
+          return true;
+        }
+      }
+    }
+    if (const auto* unaryOperator = llvm::dyn_cast<UnaryOperator>(&expr)) {
+      if (unaryOperator->isArithmeticOp() ||
+          unaryOperator->isIncrementDecrementOp()) {
+        if (isBasicSLSizeExpr(*unaryOperator->getSubExpr()->IgnoreParenImpCasts())) {
+          return true;
+        }
+      }
+    }
+    if (const auto* callExpr = llvm::dyn_cast<CallExpr>(&expr)) {
+      // max() or min() with SLSize first argument
+      if (const auto* fcnDecl = callExpr->getDirectCallee()) {
+        const IdentifierInfo* id = fcnDecl->getIdentifier();
+        if ((id == mMax || id == mMin) &&
+            callExpr->getNumArgs() == 2 &&
+            isBasicSLSizeExpr(*callExpr->getArg(0)->IgnoreParenImpCasts())) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  bool isSLSizeExpr(const Expr& expr) const {
+    auto inserted = mSLSizeExprs.try_emplace(&expr, false);
+    if (inserted.second) {
+      // only mBasicSLSizeExprs is updated here, the iterator stays valid
+      inserted.first->second = isBasicSLSizeExpr(expr) || isArithmeticOperatorWithSLSize(expr);
+    }
+    return inserted.first->second;
+  }
+
+  // type with canonical type int, not spelled SLSize or SLIndex
+  bool isIntType(QualType type) const {
+    return !type.isNull() &&
+        type.getCanonicalType().getTypePtr() == mIntType &&
+        !isSLSizeType(type);
+  }
+
+  bool isIntExpr(const Expr& expr) const {
+    return isIntType(expr.getType()) && !isSLSizeExpr(expr);
+  }
+
+  // type spelled size_t
+  bool isSizetType(QualType type) const {
+    return getTypedefName(type) == mSizeT;
+  }
+
+  bool isSizetExpr(const Expr& expr) const {
+    return isSizetType(expr.getType()) && !isSLSizeExpr(expr);
+  }
+
+ private:
+  // return the name of the typedef the type is spelled with, or nullptr
+  static const IdentifierInfo* getTypedefName(QualType type) {
+    if (type.isNull()) return nullptr;
+    const Type* typePtr = type.getTypePtr();
+    // template parameters are spelled as their argument and auto as its
+    // deduced type, parentheses and attributes are not part of the spelling
+    while (llvm::isa<SubstTemplateTypeParmType>(typePtr) || llvm::isa<DeducedType>(typePtr) ||
+           llvm::isa<ParenType>(typePtr) || llvm::isa<AttributedType>(typePtr)) {
+      const Type* desugared = typePtr->getLocallyUnqualifiedSingleStepDesugaredType().getTypePtr();
+      // auto not deduced yet
+      if (desugared == typePtr) return nullptr;
+      typePtr = desugared;
+    }
+    if (const auto* typedefType = llvm::dyn_cast<TypedefType>(typePtr)) {
+      return typedefType->getDecl()->getIdentifier();
+    }
+    return nullptr;
+  }
+
+  bool classifyBasicSLSizeExpr(const Expr& expr) const {
+    if (isSLSizeType(expr.getType())) {
       return true;
     }
+    if (const auto* operatorCall = llvm::dyn_cast<CXXOperatorCallExpr>(&expr)) {
+      return isSLSizeVectorType(operatorCall->getArg(0)->getType());
+    }
+    return false;
+  }
+
+  // type spelled vector<SLSize> or std::vector<SLSize>
+  bool isSLSizeVectorType(QualType type) const {
+    if (type.isNull()) return false;
+    const Type* typePtr = type.getTypePtr();
+    if (const auto* elaborated = llvm::dyn_cast<ElaboratedType>(typePtr)) {
+      const NestedNameSpecifier* qualifier = elaborated->getQualifier();
+      if (qualifier && (qualifier->getPrefix() ||
+                        !qualifier->getAsNamespace() ||
+                        qualifier->getAsNamespace()->getIdentifier() != mStd)) {
+        return false;
+      }
+      typePtr = elaborated->getNamedType().getTypePtr();
+    }
+    const auto* specialization = llvm::dyn_cast<TemplateSpecializationType>(typePtr);
+    if (!specialization || specialization->getNumArgs() != 1) return false;
+    const TemplateDecl* templateDecl = specialization->getTemplateName().getAsTemplateDecl();
+    const TemplateArgument& arg = specialization->getArg(0);
+    return templateDecl && templateDecl->getIdentifier() == mVector &&
+        arg.getKind() == TemplateArgument::Type &&
+        !arg.getAsType().hasLocalQualifiers() &&
+        isSLSizeType(arg.getAsType());
+  }
+
+  const Type* mIntType;
+  const IdentifierInfo* mSLSize;
+  const IdentifierInfo* mSLIndex;
+  const IdentifierInfo* mSizeT;
+  const IdentifierInfo* mStd;
+  const IdentifierInfo* mVector;
+  const IdentifierInfo* mMax;
+  const IdentifierInfo* mMin;
+  const IdentifierInfo* mCmpDecls[6];
+  const IdentifierInfo* mCastDecls[3];
+  // expressions classified so far in the translation unit, so that
+  // subexpressions shared by the matchers are classified once
+  mutable llvm::DenseMap<const Expr*, bool> mBasicSLSizeExprs;
+  mutable llvm::DenseMap<const Expr*, bool> mSLSizeExprs;
+};
+
+AST_MATCHER(CallExpr, hasSLSizeCmpDecl) {
+  if (auto decl = Node.getDirectCallee()) {
+    return SLSizeClassifier::get(Finder->getASTContext()).isSLSizeCmpDecl(decl);
   }
   return false;
 }
 
 AST_MATCHER(CallExpr, hasSLSizeCastDecl) {
   if (auto decl = Node.getDirectCallee()) {
-    std::string name = decl->getNameAsString();
-    if (name == "DimValue2Int" ||
-        name == "DimValue2Sizet" ||
-        name == "DimValue2SLSize") {
-      return true;
-    }
+    return SLSizeClassifier::get(Finder->getASTContext()).isSLSizeCastDecl(decl);
   }
   return false;
 }
 
 // match if the value type is SLSize
 AST_MATCHER(QualType, isSLSizeType) {
-  if (Node.isNull()) return false;
-    
-  auto typeName = Node.getUnqualifiedType().getAsString();
-
-  if (typeName == "SLSize" || typeName == "SLIndex") {
-    return true;
-  }
-
-  return false;    
+  return SLSizeClassifier::get(Finder->getASTContext()).isSLSizeType(Node);
 }
 
 // match is the expr is SLSize type variable,
 // value returned by vector<SLSize> index operator
 AST_MATCHER(Expr, isBasicSLSizeExpr) {
-  BoundNodesTreeBuilder tmpBuilder;
-  if (qualType(isSLSizeType()).matches(Node.getType(), Finder, &tmpBuilder)) {
-    return true;
-  }
-  // value returned by vector<SLSize> index operator
-  else if (auto cxxOperatorCallExpr = llvm::dyn_cast<CXXOperatorCallExpr>(&Node)) {
-    auto argTypeName = cxxOperatorCallExpr->getArg(0)->getType().getUnqualifiedType().getAsString();
-    if (argTypeName == "vector<SLSize>" || argTypeName == "std::vector<SLSize>") return true;
-  }
-  return false;
+  return SLSizeClassifier::get(Finder->getASTContext()).isBasicSLSizeExpr(Node);
 }
 
 // match if the result of the arithmetic expression is SLSize
 AST_MATCHER(Expr, isArithmeticOperatorWithSLSize) {
-  BoundNodesTreeBuilder tmpBuilder;
-  if (auto binaryOperator = llvm::dyn_cast<BinaryOperator>(&Node))
-  {
-    // Node is Binaryoperator
-    if (binaryOperator->isAdditiveOp() ||
-        binaryOperator->isMultiplicativeOp() ||
-        binaryOperator->isShiftOp()) {
-      // is arithmetic operator
-      if (expr(isBasicSLSizeExpr()).matches(*(binaryOperator->getLHS()->IgnoreParenImpCasts()),
-                                            Finder, &tmpBuilder) ||
-          expr(isBasicSLSizeExpr()).matches(*(binaryOperator->getRHS()->IgnoreParenImpCasts()),
-                                            Finder, &tmpBuilder)) {
-        return true;
-      }
-    }
-  }
-  if (auto unaryOperator = llvm::dyn_cast<UnaryOperator>(&Node))
-  {
-    // Node is Unaryoperator
-    if (unaryOperator->isArithmeticOp() ||
-        unaryOperator->isIncrementDecrementOp()) {
-      // is arithmetic operator or IncrementDecrement operator
-      if (expr(isBasicSLSizeExpr()).matches(*(unaryOperator->getSubExpr()->IgnoreParenImpCasts()),
-                                            Finder, &tmpBuilder)) {
-        return true;
-      }
-    }
-  }
-  if (auto callExpr = llvm::dyn_cast<CallExpr>(&Node))
-  {
-    // Node is call expr
-    if (auto fcnDecl = callExpr->getDirectCallee()) {
-      auto fcnName = fcnDecl->getNameAsString();
-      if (fcnName == "max" ||
-          fcnName == "min" ||
-          fcnName == "std::max" ||
-          fcnName == "std::min") {                
-        // is max() or min()
-        if (callExpr->getNumArgs() == 2 &&
-            expr(isBasicSLSizeExpr()).matches(*(callExpr->getArg(0)->IgnoreParenImpCasts()),
-                                              Finder, &tmpBuilder)) {
-          return true;
-        }
-      }
-    }
-  }
-  return false;
+  return SLSizeClassifier::get(Finder->getASTContext()).isArithmeticOperatorWithSLSize(Node);
 }
 
 // match if the expression is SLSize type
 AST_MATCHER(Expr, isSLSizeExpr) {
-  BoundNodesTreeBuilder tmpBuilder;
-  if (expr(isBasicSLSizeExpr()).matches(Node, Finder, &tmpBuilder) ||
-      expr(isArithmeticOperatorWithSLSize()).matches(Node, Finder, &tmpBuilder)) {
-    return true;
-  }
-  return false;
+  return SLSizeClassifier::get(Finder->getASTContext()).isSLSizeExpr(Node);
 }
 
 // match if the type is int
 AST_MATCHER(QualType, isIntType) {
-  if (Node.isNull()) return false;
-    
-  auto typeName = Node.getUnqualifiedType().getAsString();
-  auto canonicalTypeName = Node.getCanonicalType().getUnqualifiedType().getAsString();
-  if (canonicalTypeName == "int" && typeName != "SLSize" && typeName != "SLIndex") {
-    return true;
-  }
-  return false;
+  return SLSizeClassifier::get(Finder->getASTContext()).isIntType(Node);
 }
 
 // match if the expr is int type
 AST_MATCHER(Expr, isIntExpr) {
-  BoundNodesTreeBuilder tmpBuilder;
-  if (qualType(isIntType()).matches(Node.getType(), Finder, &tmpBuilder) &&
-      !expr(isSLSizeExpr()).matches(Node, Finder, &tmpBuilder)) {
-    return true;
-  }
-  return false;
+  return SLSizeClassifier::get(Finder->getASTContext()).isIntExpr(Node);
 }
 
 // match if the type is size_t
 AST_MATCHER(QualType, isSizetType) {
-  if (Node.isNull()) return false;
-    
-  auto typeName = Node.getUnqualifiedType().getAsString();
-  if (typeName == "size_t") {
-    return true;
-  }
-  return false;
+  return SLSizeClassifier::get(Finder->getASTContext()).isSizetType(Node);
 }
 
 // match is the expr is size_t
 AST_MATCHER(Expr, isSizetExpr) {
-  BoundNodesTreeBuilder tmpBuilder;
-  if (qualType(isSizetType()).matches(Node.getType(), Finder, &tmpBuilder) &&
-      !expr(isSLSizeExpr()).matches(Node, Finder, &tmpBuilder)) {
-    return true;
-  }
-  return false;
+  return SLSizeClassifier::get(Finder->getASTContext()).isSizetExpr(Node);
 }
 
 } // end clang namespace
@@ -0,0 +1,64 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef PREFILTER_HPP
+#define PREFILTER_HPP
+
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+// Textual prefilter of the files likely to match. A file is likely to match if
+// its text contains one of the given identifiers as a whole token. It reads
+// the main files only, so it is used to order the files but never to skip them
+class Prefilter {
+ public:
+  // return false and leave the prefilter empty if any token is not an identifier
+  bool SetTokens(const std::vector<std::string>& tokens);
+
+  bool empty() const {
+    return mTokens.empty();
+  }
+
+  // return true if the given text contains one of the tokens
+  bool Match(llvm::StringRef text) const;
+
+  // return for each file whether it is likely to match. the files are read in
+  // parallel by the given number of threads and unreadable files are unlikely
+  std::vector<bool> MatchFiles(const std::vector<std::string>& files,
+                               unsigned int numThreads) const;
+
+ private:
+  // sorted tokens
+  std::vector<std::string> mTokens;
+};
+
+// order the given files so that each batch of PartitionFiles processes the
+// files likely to match first, spread evenly over the batches
+std::vector<std::string> ScheduleLikelyFirst(const std::vector<std::string>& files,
+                                             const std::vector<bool>& likely,
+                                             unsigned int numThreads);
+
+#endif
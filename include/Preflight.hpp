@@ -0,0 +1,87 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef PREFLIGHT_HPP
+#define PREFLIGHT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ostream>
+
+class IncludeGraph;
+
+// approximate number of source bytes parsed per second by one thread
+constexpr double kParseBytesPerSecond = 4.0 * 1024 * 1024;
+
+// estimated parse cost of a source file
+struct FileCost
+{
+  std::string file;
+  // number of headers reached
+  size_t numHeaders = 0;
+  // size of the file and all the headers reached
+  uint64_t bytes = 0;
+  // predicted parse time in seconds
+  double seconds = 0;
+};
+
+// a header and the number of files reaching it
+struct HeaderFanIn
+{
+  std::string header;
+  size_t numIncluders = 0;
+  // size of the header
+  uint64_t bytes = 0;
+};
+
+// cost estimate of a run over a set of source files
+struct PreflightReport
+{
+  // files sorted by decreasing cost
+  std::vector<FileCost> files;
+  // headers sorted by decreasing include volume, i.e. size times fan-in
+  std::vector<HeaderFanIn> headers;
+  // bytes parsed by all the files
+  uint64_t includeVolume = 0;
+  // bytes of the distinct files reached
+  uint64_t uniqueBytes = 0;
+  // number of threads ProcessFiles would start
+  size_t numBatches = 0;
+  // predicted wall time in seconds
+  double wallSeconds = 0;
+};
+
+// estimate the cost of processing the given files with ProcessFiles at the
+// given number of threads, from their headers recorded in the include graph
+PreflightReport GetPreflightReport(const IncludeGraph& graph,
+                                   const std::vector<std::string>& files,
+                                   unsigned int numThreads,
+                                   double bytesPerSecond = kParseBytesPerSecond);
+
+// print the given number of the most expensive files and headers in the report
+void PrintPreflightReport(const PreflightReport& report, std::ostream& os,
+                          size_t numEntries = 10);
+
+#endif
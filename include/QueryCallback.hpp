@@ -0,0 +1,43 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef QUERY_CALLBACK_HPP
+#define QUERY_CALLBACK_HPP
+
+#include <memory>
+#include <string>
+
+#include "clang/ASTMatchers/ASTMatchersInternal.h"
+
+// id of the matcher running the matcher expression given with --query
+constexpr const char* kQueryMatcherId = "Query";
+
+// Parse a matcher expression in clang-query syntax, e.g.
+// callExpr(callee(functionDecl(hasName("foo")))), bound to "root".
+// Each expression is parsed once and shared by the callbacks of all the threads.
+// Throw CommandLineOptionException with the parser diagnostics if invalid
+std::shared_ptr<const clang::ast_matchers::internal::DynTypedMatcher>
+ParseQuery(const std::string& expression);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef SAMPLING_HPP
+#define SAMPLING_HPP
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// select about the given fraction of the files, at least one, spread evenly
+// over the directories. Files are grouped by directory and every
+// (1 / fraction)-th file is taken from a random start, so that each directory
+// contributes its share of the sample. return the files in sampling order
+std::vector<std::string> SampleFiles(std::vector<std::string> files, double fraction,
+                                     uint64_t seed);
+
+// cost and output of the matchers on one source file
+struct FileStats
+{
+  // nodes logged by LogASTNode and LogReplacement
+  uint64_t matches = 0;
+  uint64_t replacements = 0;
+  // bytes of replacement text
+  uint64_t replacementBytes = 0;
+  // time to parse and match the file in seconds
+  double seconds = 0;
+};
+
+// stats of the files processed by a --sample run, shared by all the threads
+class SampleStats
+{
+ public:
+  SampleStats() = default;
+  SampleStats(const SampleStats&) = delete;
+  SampleStats& operator=(const SampleStats&) = delete;
+
+  // add the stats of the given absolute file. a file compiled by several commands adds up
+  void Add(const std::string& file, const FileStats& stats);
+
+  // return the stats of the given file, zero if it was not processed
+  FileStats Get(const std::string& file) const;
+
+ private:
+  mutable std::mutex mMutex;
+  std::map<std::string, FileStats> mFiles;
+};
+
+// extrapolated total with the half-width of its 95% confidence interval.
+// the margin is unknown with a single sampled file
+struct Estimate
+{
+  double value = 0;
+  double margin = 0;
+  bool hasMargin = false;
+};
+
+// totals of a full run extrapolated from a sample
+struct SampleEstimate
+{
+  size_t numFiles = 0;
+  size_t numSampled = 0;
+  Estimate matches;
+  Estimate replacements;
+  Estimate replacementBytes;
+  // time to process all the files by one thread
+  Estimate fileSeconds;
+  // number of threads ProcessFiles would start for all the files
+  size_t numBatches = 0;
+  Estimate wallSeconds;
+};
+
+// extrapolate the totals over the given number of files from the stats of the
+// sampled files, given in sampling order. The variance is estimated from the
+// differences between successive files, which accounts for the stratification
+// by directory
+SampleEstimate EstimateTotals(const SampleStats& stats,
+                              const std::vector<std::string>& sampledFiles,
+                              size_t numFiles,
+                              unsigned int numThreads);
+
+void PrintSampleEstimate(const SampleEstimate& estimate, std::ostream& os);
+
+#endif
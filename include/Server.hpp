@@ -0,0 +1,100 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "CodeXformOptions.hpp"
+
+#include <string>
+#include <vector>
+#include <limits>
+
+#include "llvm/ADT/StringRef.h"
+
+// forward declarations
+namespace clang {
+namespace tooling {
+
+class CompilationDatabase;
+
+} // end namespace tooling
+} // end namespace clang
+
+// request sent by a client to process files
+struct ServerRequest
+{
+  // files to process (empty means all files)
+  std::vector<std::string> inputFiles;
+  // matchers to apply
+  std::vector<std::string> matchers;
+  // arguments for matchers
+  std::vector<std::string> matcherArgs;
+  // number of threads
+  unsigned int numThreads = std::numeric_limits<unsigned int>::max();
+  // options for processing each file
+  CodeXformOptions options;
+};
+
+// response sent by the server
+struct ServerResponse
+{
+  // number of failed tasks
+  int status = 0;
+  // error message if any
+  std::string error;
+  // replacements in yaml format
+  std::string replacements;
+};
+
+// encode a list of strings as "<size>:<string>" records
+std::string EncodeMessage(const std::vector<std::string>& fields);
+
+// decode a message generated by EncodeMessage.
+// return false if the message is malformed
+bool DecodeMessage(llvm::StringRef message, std::vector<std::string>& fields);
+
+std::string EncodeRequest(const ServerRequest& request);
+bool DecodeRequest(llvm::StringRef message, ServerRequest& request);
+
+std::string EncodeResponse(const ServerResponse& response);
+bool DecodeResponse(llvm::StringRef message, ServerResponse& response);
+
+// serve requests on the given unix socket until interrupted. the compilation
+// database and the content of the files read are kept across requests
+void RunServer(const std::string& socketFile,
+               const clang::tooling::CompilationDatabase& compilationDatabase,
+               unsigned int numThreads);
+
+// send the files to process to the server listening on the given unix socket
+// and append the replacements into the output file
+int ProcessFilesRemotely(const std::string& socketFile,
+                         const std::vector<std::string>& inputFiles,
+                         const std::string& outputFile,
+                         const std::vector<std::string>& matchers,
+                         const std::vector<std::string>& matcherArgs,
+                         unsigned int numThreads,
+                         const CodeXformOptions& options = CodeXformOptions());
+
+#endif
@@ -0,0 +1,81 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef SHARED_FILE_CACHE_HPP
+#define SHARED_FILE_CACHE_HPP
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+// A thread-safe file system caching the status and the content of the files
+// read through it. Cached entries are validated against the underlying file
+// system once per generation, so a file is stat'ed at most once per generation
+// no matter how many translation units include it. Contents are read into
+// memory and shared by all the paths referring to the same file.
+class SharedFileCache : public llvm::vfs::ProxyFileSystem {
+ public:
+  explicit SharedFileCache(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> FS =
+                           llvm::vfs::getRealFileSystem());
+
+  // start a new generation. cached entries are validated again on next access
+  void NewGeneration();
+
+  // number of distinct files whose content is cached
+  size_t GetNumCachedFiles() const;
+
+  llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override;
+
+  llvm::ErrorOr<std::unique_ptr<llvm::vfs::File> >
+  openFileForRead(const llvm::Twine& path) override;
+
+ private:
+  struct Entry {
+    unsigned generation = 0;
+    std::error_code error;
+    llvm::vfs::Status status;
+  };
+
+  struct Content {
+    llvm::vfs::Status status;
+    std::shared_ptr<llvm::MemoryBuffer> buffer;
+  };
+
+  std::string GetKey(const llvm::Twine& path);
+
+  mutable std::mutex mMutex;
+  unsigned mGeneration = 1;
+  // status of each path
+  std::unordered_map<std::string, Entry> mEntries;
+  // content of each file
+  std::map<llvm::sys::fs::UniqueID, Content> mContents;
+};
+
+#endif
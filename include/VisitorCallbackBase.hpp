@@ -0,0 +1,215 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#ifndef VISITOR_CALLBACK_BASE_HPP
+#define VISITOR_CALLBACK_BASE_HPP
+
+#include "MatchCallbackBase.hpp"
+
+#include <type_traits>
+#include <vector>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/ADT/DenseMap.h"
+
+class VisitorCallbackBase;
+
+// Single RecursiveASTVisitor pass running all the visitor callbacks. Each node
+// is dispatched by its kind to the callbacks registered for it, and the
+// callbacks of a kind are resolved the first time a node of that kind is seen
+class VisitorDispatcher : public clang::RecursiveASTVisitor<VisitorDispatcher> {
+ public:
+  VisitorDispatcher()
+      : mStmtCallbacks(clang::Stmt::lastStmtConstant + 1),
+        mDeclCallbacks(clang::Decl::lastDecl + 1)
+  {}
+
+  // call the callback for each node of type NodeT, a Stmt or Decl subclass
+  template <typename NodeT>
+  typename std::enable_if<std::is_base_of<clang::Stmt, NodeT>::value>::type
+  AddVisitor(VisitorCallbackBase* callback) {
+    mStmtVisitors.push_back({callback, &IsA<NodeT, clang::Stmt>});
+  }
+
+  template <typename NodeT>
+  typename std::enable_if<std::is_base_of<clang::Decl, NodeT>::value>::type
+  AddVisitor(VisitorCallbackBase* callback) {
+    mDeclVisitors.push_back({callback, &IsA<NodeT, clang::Decl>});
+  }
+
+  // call the callback for each call of a function accepted by its
+  // IsInterestingCallee(). The callbacks interested in a function are found
+  // the first time it is called, so a call only reaches these callbacks
+  void AddCalleeVisitor(VisitorCallbackBase* callback) {
+    mCalleeVisitors.push_back(callback);
+  }
+
+  bool empty() const {
+    return mStmtVisitors.empty() && mDeclVisitors.empty() && mCalleeVisitors.empty();
+  }
+
+  // traverse the AST in the traversal scope of the context
+  void Run(clang::ASTContext& context) {
+    mContext = &context;
+    TraverseAST(context);
+    mContext = nullptr;
+    // declarations are only valid in their translation unit
+    mCalleeCallbacks.shrink_and_clear();
+  }
+
+  // visit the same nodes as MatchFinder
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool VisitStmt(clang::Stmt* stmt);
+  bool VisitDecl(clang::Decl* decl);
+
+ private:
+  template <typename NodeT>
+  struct Visitor {
+    VisitorCallbackBase* callback;
+    bool (*accepts)(const NodeT*);
+  };
+
+  // callbacks of a node kind, resolved at first sight
+  struct KindCallbacks {
+    bool resolved = false;
+    std::vector<VisitorCallbackBase*> callbacks;
+  };
+
+  template <typename NodeT, typename BaseT>
+  static bool IsA(const BaseT* node) {
+    return llvm::isa<NodeT>(node);
+  }
+
+  template <typename NodeT>
+  static const std::vector<VisitorCallbackBase*>&
+  GetCallbacks(const NodeT* node, unsigned int kind,
+               const std::vector<Visitor<NodeT> >& visitors,
+               std::vector<KindCallbacks>& kindCallbacks) {
+    KindCallbacks& entry = kindCallbacks[kind];
+    if (!entry.resolved) {
+      for (const auto& visitor : visitors) {
+        if (visitor.accepts(node)) {
+          entry.callbacks.push_back(visitor.callback);
+        }
+      }
+      entry.resolved = true;
+    }
+    return entry.callbacks;
+  }
+
+  std::vector<Visitor<clang::Stmt> > mStmtVisitors;
+  std::vector<Visitor<clang::Decl> > mDeclVisitors;
+  std::vector<KindCallbacks> mStmtCallbacks;
+  std::vector<KindCallbacks> mDeclCallbacks;
+  std::vector<VisitorCallbackBase*> mCalleeVisitors;
+  // callbacks interested in the calls of each function, keyed by canonical declaration
+  llvm::DenseMap<const clang::FunctionDecl*, std::vector<VisitorCallbackBase*> > mCalleeCallbacks;
+  clang::ASTContext* mContext = nullptr;
+};
+
+// Base of callbacks visiting the AST nodes of given kinds directly instead of
+// running AST matchers. It suits checks on the node kind and a name, for which
+// matching and binding nodes cost more than the check itself. All the visitor
+// callbacks share a single traversal of the AST
+class VisitorCallbackBase : public MatchCallbackBase {
+ public:
+  explicit VisitorCallbackBase(const std::string& id,
+                               clang::tooling::Replacements& replacements,
+                               std::vector<std::string> args)
+      : MatchCallbackBase(id, replacements, std::move(args))
+  {}
+
+  // register the node kinds to visit with dispatcher->AddVisitor<NodeT>(this)
+  virtual void RegisterVisitors(VisitorDispatcher* dispatcher) override = 0;
+
+  // called for each node of a registered kind
+  virtual void VisitStmt(const clang::Stmt* stmt, clang::ASTContext& context) {}
+  virtual void VisitDecl(const clang::Decl* decl, clang::ASTContext& context) {}
+
+  // return true if the calls of the function are visited, for callbacks
+  // registered with dispatcher->AddCalleeVisitor(this). Called once per
+  // function and translation unit
+  virtual bool IsInterestingCallee(const clang::FunctionDecl* callee) {
+    return false;
+  }
+
+  // called for each call of a function accepted by IsInterestingCallee()
+  virtual void VisitCall(const clang::CallExpr* call, const clang::FunctionDecl* callee,
+                         clang::ASTContext& context) {}
+
+  bool IsVisitorCallback() const final {
+    return true;
+  }
+
+  // visitor callbacks have no matchers
+  void RegisterMatchers(clang::ast_matchers::MatchFinder* finder) final {}
+  void run(const clang::ast_matchers::MatchFinder::MatchResult& result) final {}
+
+ protected:
+  // same as isExpansionInMainFile() for matchers
+  static bool IsExpansionInMainFile(clang::SourceLocation loc,
+                                    const clang::SourceManager& srcMgr) {
+    return srcMgr.isInMainFile(srcMgr.getExpansionLoc(loc));
+  }
+};
+
+inline bool VisitorDispatcher::VisitStmt(clang::Stmt* stmt) {
+  for (auto* callback : GetCallbacks<clang::Stmt>(stmt, stmt->getStmtClass(),
+                                                  mStmtVisitors, mStmtCallbacks)) {
+    callback->VisitStmt(stmt, *mContext);
+  }
+  if (mCalleeVisitors.empty()) {
+    return true;
+  }
+  if (const auto* call = llvm::dyn_cast<clang::CallExpr>(stmt)) {
+    if (const clang::FunctionDecl* callee = call->getDirectCallee()) {
+      auto inserted = mCalleeCallbacks.try_emplace(callee->getCanonicalDecl());
+      if (inserted.second) {
+        for (auto* callback : mCalleeVisitors) {
+          if (callback->IsInterestingCallee(callee)) {
+            inserted.first->second.push_back(callback);
+          }
+        }
+      }
+      for (auto* callback : inserted.first->second) {
+        callback->VisitCall(call, callee, *mContext);
+      }
+    }
+  }
+  return true;
+}
+
+inline bool VisitorDispatcher::VisitDecl(clang::Decl* decl) {
+  for (auto* callback : GetCallbacks<clang::Decl>(decl, decl->getKind(),
+                                                  mDeclVisitors, mDeclCallbacks)) {
+    callback->VisitDecl(decl, *mContext);
+  }
+  return true;
+}
+
+#endif
@@ -41,6 +41,8 @@ void __NAME__Callback::RegisterMatchers(clang::ast_matchers::MatchFinder* finder
                   ).bind("__NAME__Expr"/*[4]*/);
 
   finder->addMatcher(__NAME__Matcher, this);
+  // remove if __NAME__Matcher drops isExpansionInMainFile(), see README.md
+  SetMainFileOnly();
 }
 
 // Definition of __NAME__Callback::run
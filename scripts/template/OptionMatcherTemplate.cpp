@@ -61,6 +61,8 @@ void __NAME__Callback::RegisterMatchers(clang::ast_matchers::MatchFinder* finder
                   ).bind("__NAME__Expr"/*[4]*/);
 
   finder->addMatcher(__NAME__Matcher, this);
+  // the options do not widen the match beyond the main file (SetMainFileOnly in README.md)
+  SetMainFileOnly();
 }
 
 // Definition of __NAME__Callback::run
@@ -23,17 +23,28 @@
 */
 
 #include "CodeXformAction.hpp"
+#include "CoreUtil.hpp"
 #include "cxxlog.hpp"
 #include "ToolingUtil.hpp"
 #include "MatcherFactory.hpp"
 #include "MyReplacementsYaml.hpp"
 #include "CommandLineArgsUtil.hpp"
+#include "MemoryBudget.hpp"
+#include "MatchLimit.hpp"
 
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/SourceManager.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/MultiplexConsumer.h"
+#include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/YAMLTraits.h"
 
+#include <algorithm>
 #include <iostream>
 #include <system_error>
 
@@ -44,12 +55,169 @@ using namespace llvm::sys;
 using namespace clang::ast_matchers;
 using namespace clang::tooling;
 
+namespace {
+
+// return the absolute path of the given file without dots, as stored in the include graph
+std::string GetNormalizedPath(const FileManager& fileMgr, StringRef file) {
+  SmallString<256> tmp_path(file);
+  fileMgr.makeAbsolutePath(tmp_path);
+  return ::GetNormalizedPath(tmp_path.str().str());
+}
+
+// memory allocated by the AST, the preprocessor and the source manager of the given compiler
+uint64_t GetMemoryUsage(CompilerInstance& CI) {
+  uint64_t bytes = 0;
+  if (CI.hasASTContext()) {
+    bytes += CI.getASTContext().getASTAllocatedMemory();
+    bytes += CI.getASTContext().getSideTableAllocatedMemory();
+  }
+  if (CI.hasPreprocessor()) {
+    bytes += CI.getPreprocessor().getTotalMemory();
+  }
+  if (CI.hasSourceManager()) {
+    const SourceManager& srcMgr = CI.getSourceManager();
+    auto bufferSizes = srcMgr.getMemoryBufferSizes();
+    bytes += srcMgr.getContentCacheSize() + srcMgr.getDataStructureSizes() +
+        bufferSizes.malloc_bytes + bufferSizes.mmap_bytes;
+  }
+  return bytes;
+}
+
+// AST consumer limiting the work done outside the main file
+class ScopedConsumer : public MultiplexConsumer {
+ public:
+  ScopedConsumer(std::unique_ptr<ASTConsumer> consumer,
+                 bool skipFunctionBodies,
+                 bool mainFileScope,
+                 const std::unordered_set<std::string>& scopeHeaders,
+                 const std::unordered_map<std::string, std::string>* headerOwners,
+                 const MatchLimit* matchLimit,
+                 const std::string& mainFile)
+      : MultiplexConsumer(MakeConsumers(std::move(consumer))),
+        mSkipFunctionBodies(skipFunctionBodies),
+        mMainFileScope(mainFileScope),
+        mScopeHeaders(scopeHeaders),
+        mHeaderOwners(headerOwners),
+        mMatchLimit(matchLimit),
+        mMainFile(mainFile)
+  {}
+
+  // skip function bodies outside the main file, or all the remaining ones
+  // once the match limit is reached
+  bool shouldSkipFunctionBody(Decl* D) override {
+    if (mMatchLimit && mMatchLimit->Reached()) {
+      return true;
+    }
+    if (!mSkipFunctionBodies) {
+      return false;
+    }
+    const SourceManager& srcMgr = D->getASTContext().getSourceManager();
+    return !srcMgr.isInMainFile(srcMgr.getExpansionLoc(D->getLocation()));
+  }
+
+  // restrict the traversal to the top-level declarations in scope
+  void HandleTranslationUnit(ASTContext& context) override {
+    // no need to match the file once the match limit is reached
+    if (mMatchLimit && mMatchLimit->Reached()) {
+      return;
+    }
+    if (mMainFileScope || mHeaderOwners) {
+      const SourceManager& srcMgr = context.getSourceManager();
+      llvm::DenseMap<FileID, bool> fileInScope;
+      std::vector<Decl*> scope;
+      for (Decl* D : context.getTranslationUnitDecl()->decls()) {
+        SourceLocation loc = srcMgr.getExpansionLoc(D->getLocation());
+        if (loc.isInvalid()) {
+          continue;
+        }
+        FileID fileID = srcMgr.getFileID(loc);
+        auto iter = fileInScope.find(fileID);
+        if (iter == fileInScope.end()) {
+          iter = fileInScope.insert(std::make_pair(fileID, IsInScope(srcMgr, fileID))).first;
+        }
+        if (iter->second) {
+          scope.push_back(D);
+        }
+      }
+      context.setTraversalScope(scope);
+    }
+    MultiplexConsumer::HandleTranslationUnit(context);
+  }
+
+ private:
+  static std::vector<std::unique_ptr<ASTConsumer> >
+  MakeConsumers(std::unique_ptr<ASTConsumer> consumer) {
+    std::vector<std::unique_ptr<ASTConsumer> > consumers;
+    consumers.push_back(std::move(consumer));
+    return consumers;
+  }
+
+  bool IsInScope(const SourceManager& srcMgr, FileID fileID) const {
+    if (fileID == srcMgr.getMainFileID()) {
+      return true;
+    }
+    const FileEntry* fileEntry = srcMgr.getFileEntryForID(fileID);
+    if (!fileEntry) {
+      return !mMainFileScope;
+    }
+    StringRef realName = fileEntry->tryGetRealPathName();
+    std::string name = realName.empty() ? fileEntry->getName().str() : realName.str();
+    if (mScopeHeaders.count(name)) {
+      return true;
+    }
+    if (mHeaderOwners) {
+      // paths in the include graph are normalized but not resolved
+      auto iter = mHeaderOwners->find(GetNormalizedPath(srcMgr.getFileManager(),
+                                                        fileEntry->getName()));
+      if (iter == mHeaderOwners->end()) {
+        iter = mHeaderOwners->find(name);
+      }
+      if (iter != mHeaderOwners->end()) {
+        return iter->second == mMainFile;
+      }
+    }
+    // headers without an owner are traversed unless limited to the main file
+    return !mMainFileScope;
+  }
+
+  bool mSkipFunctionBodies;
+  bool mMainFileScope;
+  const std::unordered_set<std::string>& mScopeHeaders;
+  const std::unordered_map<std::string, std::string>* mHeaderOwners;
+  const MatchLimit* mMatchLimit;
+  std::string mMainFile;
+};
+
+// AST consumer running the visitor callbacks
+class VisitorConsumer : public ASTConsumer {
+ public:
+  explicit VisitorConsumer(VisitorDispatcher& dispatcher)
+      : mDispatcher(dispatcher)
+  {}
+
+  void HandleTranslationUnit(ASTContext& context) override {
+    mDispatcher.Run(context);
+  }
+
+ private:
+  VisitorDispatcher& mDispatcher;
+};
+
+} // end anonymous namespace
+
 std::mutex CodeXformAction::mMutex;
 
-CodeXformAction::CodeXformAction(const std::string& outputFile,
-                                 const std::vector<std::string>& ids,
-                                 const std::vector<std::string>& args)
-    : mOutputFile(outputFile)
+CodeXformState::CodeXformState(const std::vector<std::string>& ids,
+                               const std::vector<std::string>& args,
+                               const CodeXformOptions& options)
+    : mMainFileScope(options.mainFileScope || !options.scopeHeaders.empty()),
+      mScopeHeaders(options.scopeHeaders.begin(), options.scopeHeaders.end()),
+      mHeaderOwners(options.headerOwners),
+      mMemoryBudget(options.memoryBudget),
+      mFindIndex(options.findIndex),
+      mMatchCounts(options.matchCounts),
+      mSampleStats(options.sampleStats),
+      mMatchLimit(options.matchLimit)
 {
   // register command line options for each MatchCallback
   MatcherFactory& factory = MatcherFactory::Instance();
@@ -62,6 +230,7 @@ CodeXformAction::CodeXformAction(const std::string& outputFile,
       assert(mCallbacks.back());
       // register command line options and matchers
       mCallbacks.back()->Register(&mFinder);
+      mCallbacks.back()->RegisterVisitors(&mDispatcher);
     } else {
       // create multiple instances of the given matcher with different arguments setting
       for (auto& args : matcher_args) {
@@ -70,20 +239,133 @@ CodeXformAction::CodeXformAction(const std::string& outputFile,
         assert(mCallbacks.back());
         // register command line options and matchers
         mCallbacks.back()->Register(&mFinder);
+        mCallbacks.back()->RegisterVisitors(&mDispatcher);
       }
     }
   }
+
+  if (mFindIndex) {
+    for (auto& callback : mCallbacks) {
+      callback->SetFindIndex(&mFindHits);
+    }
+  }
+  if (mMatchCounts) {
+    for (auto& callback : mCallbacks) {
+      callback->SetCountOnly();
+    }
+  }
+  if (mMatchLimit) {
+    for (auto& callback : mCallbacks) {
+      callback->SetMatchLimit(mMatchLimit.get());
+    }
+  }
+
+  mHasMatchers = std::any_of(mCallbacks.begin(), mCallbacks.end(),
+                             [](const std::unique_ptr<MatchCallbackBase>& callback)
+                             {return !callback->IsVisitorCallback();});
+  mMainFileOnly = !mCallbacks.empty() &&
+      std::all_of(mCallbacks.begin(), mCallbacks.end(),
+                  [](const std::unique_ptr<MatchCallbackBase>& callback)
+                  {return callback->IsMainFileOnly();});
+}
+
+void CodeXformState::Reset() {
+  mReplacements.clear();
+  mFindHits.clear();
+  for (auto& callback : mCallbacks) {
+    callback->EndMatch();
+    callback->Reset();
+  }
+}
+
+CodeXformAction::CodeXformAction(const std::string& outputFile,
+                                 const std::vector<std::string>& ids,
+                                 const std::vector<std::string>& args,
+                                 const CodeXformOptions& options)
+    : CodeXformAction(outputFile, std::make_shared<CodeXformState>(ids, args, options))
+{}
+
+CodeXformAction::CodeXformAction(const std::string& outputFile,
+                                 std::shared_ptr<CodeXformState> state)
+    : mOutputFile(outputFile),
+      mState(std::move(state))
+{}
+
+CodeXformAction::~CodeXformAction() {
+  // the file may fail before EndSourceFileAction
+  if (!mAdmittedFile.empty()) {
+    mState->mMemoryBudget->Release(mAdmittedFile, 0);
+  }
+  // the AST of the file is freed by now. the memory budget samples the resident
+  // set size, so give the memory back for it to only count the files in flight
+  if (mState->mMemoryBudget) {
+    ReleaseFreeMemory();
+  }
+}
+
+std::unique_ptr<ASTConsumer>
+CodeXformAction::CreateASTConsumer(CompilerInstance &CI, StringRef inFile) {
+  CodeXformState& state = *mState;
+  // the match finder traverses the AST even without matchers, skip it then
+  std::unique_ptr<ASTConsumer> consumer;
+  if (state.mDispatcher.empty()) {
+    consumer = state.mFinder.newASTConsumer();
+  } else if (!state.mHasMatchers) {
+    consumer = std::make_unique<VisitorConsumer>(state.mDispatcher);
+  } else {
+    std::vector<std::unique_ptr<ASTConsumer> > consumers;
+    consumers.push_back(state.mFinder.newASTConsumer());
+    consumers.push_back(std::make_unique<VisitorConsumer>(state.mDispatcher));
+    consumer = std::make_unique<MultiplexConsumer>(std::move(consumers));
+  }
+  if (!state.mMainFileOnly && !state.mMainFileScope && !state.mHeaderOwners &&
+      !state.mMatchLimit) {
+    return consumer;
+  }
+  return std::make_unique<ScopedConsumer>(std::move(consumer), state.mMainFileOnly,
+                                          state.mMainFileScope, state.mScopeHeaders,
+                                          state.mHeaderOwners.get(), state.mMatchLimit.get(),
+                                          GetNormalizedPath(CI.getFileManager(), inFile));
 }
 
 bool CodeXformAction::BeginSourceFileAction (CompilerInstance &CI) {
   TRIVIAL_LOG(info) << "Processing file: " << getCurrentFile().str() << '\n';
+  // function bodies are only skipped if the consumer agrees
+  if (mState->mMainFileOnly || mState->mMatchLimit) {
+    CI.getFrontendOpts().SkipFunctionBodies = true;
+  }
+  // wait until the file fits into the memory budget before parsing it
+  if (mState->mMemoryBudget) {
+    mAdmittedFile = getCurrentFile().str();
+    mState->mMemoryBudget->Acquire(mAdmittedFile);
+  }
+  mStartTime = std::chrono::steady_clock::now();
   return true;
 }
 
 void CodeXformAction::EndSourceFileAction() {
+  if (!mAdmittedFile.empty()) {
+    mState->mMemoryBudget->Release(mAdmittedFile, GetMemoryUsage(getCompilerInstance()));
+    mAdmittedFile.clear();
+  }
+
+  if (mState->mSampleStats) {
+    WriteStats();
+  }
+  // write the nodes found or the replacements if any
+  if (mState->mMatchCounts) {
+    WriteCounts();
+  } else if (mState->mFindIndex) {
+    mState->mFindIndex->Append(mState->mFindHits);
+  } else if (!mState->mReplacements.empty() && !mOutputFile.get().empty()) {
+    WriteReplacements();
+  }
+  // the state is reused by the next file
+  mState->Reset();
+}
+
+void CodeXformAction::WriteReplacements() {
   // see https://github.com/llvm-mirror/clang/blob/master/tools/clang-rename/ClangRename.cpp
-  // return if no replacements
-  if (mReplacements.empty()) return;
   std::error_code EC;
 
   std::lock_guard<std::mutex> guard(mMutex);
@@ -94,13 +376,42 @@ void CodeXformAction::EndSourceFileAction() {
   }
 
   tooling::TranslationUnitReplacements TUR;
-  TUR.MainSourceFile = getCurrentFile().str();
+  // the main file is spelled as in the compile command, possibly relative to
+  // its directory. the normalized path matches the input files of main.cpp
+  TUR.MainSourceFile = GetNormalizedPath(getCompilerInstance().getFileManager(),
+                                         getCurrentFile());
   TUR.Replacements.insert(TUR.Replacements.end(),
-                          mReplacements.begin(),
-                          mReplacements.end());
+                          mState->mReplacements.begin(),
+                          mState->mReplacements.end());
 
   yaml::Output YAML(OS);
   YAML << TUR;
   OS.close();
-  mReplacements.clear();
+}
+
+void CodeXformAction::WriteCounts() {
+  const SourceManager& srcMgr = getCompilerInstance().getSourceManager();
+  for (auto& callback : mState->mCallbacks) {
+    for (const auto& pair : callback->TakeCounts()) {
+      const FileEntry* fileEntry = srcMgr.getFileEntryForID(pair.first);
+      mState->mMatchCounts->Add(callback->GetId(),
+                                fileEntry ? fileEntry->getName().str() : getCurrentFile().str(),
+                                pair.second);
+    }
+  }
+}
+
+void CodeXformAction::WriteStats() {
+  FileStats stats;
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                mStartTime).count();
+  for (auto& callback : mState->mCallbacks) {
+    stats.matches += callback->TakeNumNodes();
+  }
+  stats.replacements = mState->mReplacements.size();
+  for (const auto& replacement : mState->mReplacements) {
+    stats.replacementBytes += replacement.getReplacementText().size();
+  }
+  mState->mSampleStats->Add(GetNormalizedPath(getCompilerInstance().getFileManager(),
+                                              getCurrentFile()), stats);
 }
@@ -24,7 +24,22 @@
 
 #include "CodeXformActionFactory.hpp"
 #include "CodeXformAction.hpp"
+#include "MatchLimit.hpp"
 
 clang::FrontendAction* CodeXformActionFactory::create() {
-  return new CodeXformAction(mOutputFile.get(), mMatchers.get(), mMatcherArgs.get());
+  if (!mState) {
+    mState = std::make_shared<CodeXformState>(mMatchers.get(), mMatcherArgs.get(), mOptions);
+  }
+  return new CodeXformAction(mOutputFile.get(), mState);
+}
+
+bool CodeXformActionFactory::runInvocation(std::shared_ptr<clang::CompilerInvocation> invocation,
+                                           clang::FileManager* files,
+                                           std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                                           clang::DiagnosticConsumer* diagConsumer) {
+  if (mOptions.matchLimit && mOptions.matchLimit->Reached()) {
+    return true;
+  }
+  return FrontendActionFactory::runInvocation(std::move(invocation), files,
+                                              std::move(pchContainerOps), diagConsumer);
 }
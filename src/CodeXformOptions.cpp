@@ -0,0 +1,63 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CodeXformOptions.hpp"
+
+namespace {
+
+const std::string kMainFileScope = "main-file-scope";
+const std::string kScopeHeader = "scope-header";
+
+} // end anonymous namespace
+
+std::vector<std::string> EncodeOptions(const CodeXformOptions& options) {
+  std::vector<std::string> fields;
+  if (options.mainFileScope) {
+    fields.push_back(kMainFileScope + "=1");
+  }
+  for (const auto& header : options.scopeHeaders) {
+    fields.push_back(kScopeHeader + '=' + header);
+  }
+  return fields;
+}
+
+bool DecodeOptions(const std::vector<std::string>& fields, CodeXformOptions& options) {
+  options = CodeXformOptions();
+  for (const auto& field : fields) {
+    auto pos = field.find('=');
+    if (pos == std::string::npos) {
+      return false;
+    }
+    std::string key = field.substr(0, pos);
+    std::string value = field.substr(pos + 1);
+    if (key == kMainFileScope) {
+      options.mainFileScope = (value == "1");
+    } else if (key == kScopeHeader) {
+      options.scopeHeaders.push_back(std::move(value));
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
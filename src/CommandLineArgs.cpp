@@ -27,6 +27,8 @@
 #include "CoreUtil.hpp"
 #include "MatcherFactory.hpp"
 #include "MatchCallbackBase.hpp"
+#include "MemoryBudget.hpp"
+#include "QueryCallback.hpp"
 
 #include "llvm/Support/Path.h"
 
@@ -48,7 +50,31 @@ CommandLineArgs ProcessCommandLine(int argc, char**argv)
       ("d, display", "display registered matchers", cxxopts::value<bool>())
       ("q, quiet", "silent output", cxxopts::value<bool>())
       ("v, version", "version number", cxxopts::value<bool>())
-      ("l, log", "log file", cxxopts::value<std::string>());
+      ("l, log", "log file", cxxopts::value<std::string>())
+      ("gen-header-compdb", "generate compile commands for headers", cxxopts::value<bool>())
+      ("cache-dir", "cache directory", cxxopts::value<std::string>())
+      ("list-includers", "list files including the given header", cxxopts::value<std::string>())
+      ("list-includes", "list headers included by the given file", cxxopts::value<std::string>())
+      ("incremental", "only process files affected by changes since the last run", cxxopts::value<bool>())
+      ("server", "serve requests on the given unix socket", cxxopts::value<std::string>())
+      ("connect", "send requests to the server on the given unix socket", cxxopts::value<std::string>())
+      ("watch", "re-run matchers when files are modified", cxxopts::value<bool>())
+      ("main-file-scope", "only traverse top-level declarations in the main file", cxxopts::value<bool>())
+      ("scope-headers", "headers whose top-level declarations are traversed as well",
+       cxxopts::value<std::vector<std::string> >())
+      ("header-ownership", "only match each header in the cheapest file including it", cxxopts::value<bool>())
+      ("preflight", "estimate the cost of a run without running matchers", cxxopts::value<bool>())
+      ("memory-budget", "memory used by the files processed concurrently", cxxopts::value<std::string>())
+      ("load-matchers", "shared libraries registering more matchers",
+       cxxopts::value<std::vector<std::string> >())
+      ("query", "matcher expression in clang-query syntax to run", cxxopts::value<std::string>())
+      ("find-index", "record the nodes found into a columnar file instead of replacements",
+       cxxopts::value<std::string>())
+      ("index-counts", "print the hits of a find index per matcher and directory",
+       cxxopts::value<std::string>())
+      ("count-only", "only count the nodes found per matcher and file", cxxopts::value<bool>())
+      ("sample", "estimate a full run from the given fraction of the files", cxxopts::value<double>())
+      ("max-matches", "stop once the given number of nodes are found", cxxopts::value<int>());
 
   options.parse_positional({"input-files"});
 
@@ -98,6 +124,86 @@ CommandLineArgs ProcessCommandLine(int argc, char**argv)
     args.logFile = result["log"].as<std::string>();
   }
 
+  if (result.count("gen-header-compdb")) {
+    args.genHeaderCompDB = result["gen-header-compdb"].as<bool>();
+  }
+
+  if (result.count("cache-dir")) {
+    args.cacheDir = result["cache-dir"].as<std::string>();
+  }
+
+  if (result.count("list-includers")) {
+    args.listIncluders = result["list-includers"].as<std::string>();
+  }
+
+  if (result.count("list-includes")) {
+    args.listIncludes = result["list-includes"].as<std::string>();
+  }
+
+  if (result.count("incremental")) {
+    args.incremental = result["incremental"].as<bool>();
+  }
+
+  if (result.count("server")) {
+    args.server = result["server"].as<std::string>();
+  }
+
+  if (result.count("connect")) {
+    args.connect = result["connect"].as<std::string>();
+  }
+
+  if (result.count("watch")) {
+    args.watch = result["watch"].as<bool>();
+  }
+
+  if (result.count("main-file-scope")) {
+    args.mainFileScope = result["main-file-scope"].as<bool>();
+  }
+
+  if (result.count("scope-headers")) {
+    args.scopeHeaders = result["scope-headers"].as<std::vector<std::string> >();
+  }
+
+  if (result.count("header-ownership")) {
+    args.headerOwnership = result["header-ownership"].as<bool>();
+  }
+
+  if (result.count("preflight")) {
+    args.preflight = result["preflight"].as<bool>();
+  }
+
+  if (result.count("memory-budget")) {
+    args.memoryBudget = result["memory-budget"].as<std::string>();
+  }
+
+  if (result.count("load-matchers")) {
+    args.loadMatchers = result["load-matchers"].as<std::vector<std::string> >();
+  }
+
+  if (result.count("query")) {
+    args.query = result["query"].as<std::string>();
+  }
+
+  if (result.count("find-index")) {
+    args.findIndex = result["find-index"].as<std::string>();
+  }
+
+  if (result.count("index-counts")) {
+    args.indexCounts = result["index-counts"].as<std::string>();
+  }
+
+  if (result.count("count-only")) {
+    args.countOnly = result["count-only"].as<bool>();
+  }
+
+  if (result.count("sample")) {
+    args.sample = result["sample"].as<double>();
+  }
+
+  if (result.count("max-matches")) {
+    args.maxMatches = result["max-matches"].as<int>();
+  }
+
   if (result.count("help"))
   {
     std::cout << options.help({"Group"}) << std::endl;
@@ -108,9 +214,18 @@ CommandLineArgs ProcessCommandLine(int argc, char**argv)
 }
 
 bool AdjustCommandLineArgs(CommandLineArgs& args, std::vector<std::string>& matcherArgs) {
+  // --query EXPR is run by the matcher Query with argument --expression EXPR
+  bool adjusted = false;
+  if (!args.query.empty()) {
+    args.matchers.push_back(kQueryMatcherId);
+    matcherArgs.insert(matcherArgs.end(), {std::string("--matcher-args-") + kQueryMatcherId,
+                                           "--expression", args.query});
+    adjusted = true;
+  }
+
   // if cfg file is specified, read the flags and adjust args
   if (args.configFile.empty()) {
-    return false;
+    return adjusted;
   }
 
   std::vector<std::string> extraMatchers = ParseConfigFile(args.configFile, "matchers");
@@ -148,7 +263,24 @@ bool ValidateCommandLineArgs(const CommandLineArgs& args, const std::vector<std:
       + !args.inputFiles.empty()
       + !args.matchers.empty() + !args.outputFile.empty()
       + !args.replaceFile.empty()
-      + args.display;
+      + args.display
+      + args.genHeaderCompDB
+      + !args.listIncluders.empty()
+      + !args.listIncludes.empty()
+      + args.incremental
+      + !args.server.empty()
+      + !args.connect.empty()
+      + args.watch
+      + args.mainFileScope
+      + !args.scopeHeaders.empty()
+      + args.headerOwnership
+      + args.preflight
+      + !args.memoryBudget.empty()
+      + !args.findIndex.empty()
+      + !args.indexCounts.empty()
+      + args.countOnly
+      + (args.sample != 0)
+      + (args.maxMatches != 0);
   // Flags --apply should be mutually exclusive with the rest options
   if (!args.replaceFile.empty() && flagsum > 1) {
     errmsg = "Options --apply should be mutually exclusive with the rest options";
@@ -159,6 +291,108 @@ bool ValidateCommandLineArgs(const CommandLineArgs& args, const std::vector<std:
     errmsg = "Options --display should be mutually exclusive with the rest options";
     return false;
   }
+  // Flags --gen-header-compdb should only be used with --compile-commands
+  if (args.genHeaderCompDB && (args.compileCommands.empty() || flagsum > 2)) {
+    errmsg = "Options --gen-header-compdb should only be used with --compile-commands";
+    return false;
+  }
+  // Flags --preflight should only be used with --compile-commands
+  if (args.preflight && (args.compileCommands.empty() || flagsum > 2)) {
+    errmsg = "Options --preflight should only be used with --compile-commands";
+    return false;
+  }
+  // Flags --list-includers and --list-includes should only be used with --compile-commands
+  int numQueries = !args.listIncluders.empty() + !args.listIncludes.empty();
+  if (numQueries && (args.compileCommands.empty() || flagsum > numQueries + 1)) {
+    errmsg = "Options --list-includers and --list-includes should only be used with --compile-commands";
+    return false;
+  }
+  // Flags --incremental should only be used when exporting replacements, since the
+  // cache would not match the sources once the replacements are applied
+  if (args.incremental && (args.matchers.empty() || args.outputFile.empty())) {
+    errmsg = "Options --incremental should only be used with --matchers and --output";
+    return false;
+  }
+  // Flags --server should only be used with --compile-commands
+  if (!args.server.empty() && (args.compileCommands.empty() || flagsum > 2)) {
+    errmsg = "Options --server should only be used with --compile-commands";
+    return false;
+  }
+  // Flags --connect is mutually exclusive with --compile-commands and -- [CLANG_FLAGS]
+  if (!args.connect.empty() && (!args.compileCommands.empty() || hasClangFlags ||
+                                args.matchers.empty() || args.incremental)) {
+    errmsg = "Options --connect should only be used with --matchers, --input-files and --output";
+    return false;
+  }
+  // Flags --watch should be used with --compile-commands, --matchers and --output
+  if (args.watch && (args.compileCommands.empty() || args.matchers.empty() ||
+                     args.outputFile.empty() || args.incremental)) {
+    errmsg = "Options --watch should be used with --compile-commands, --matchers and --output";
+    return false;
+  }
+  // Flags --main-file-scope and --scope-headers should only be used when applying matchers
+  if ((args.mainFileScope || !args.scopeHeaders.empty()) && args.matchers.empty()) {
+    errmsg = "Options --main-file-scope and --scope-headers should only be used with --matchers";
+    return false;
+  }
+  // Flags --header-ownership should be used with --compile-commands and --matchers
+  if (args.headerOwnership && (args.compileCommands.empty() || args.matchers.empty() ||
+                               args.incremental)) {
+    errmsg = "Options --header-ownership should be used with --compile-commands and --matchers";
+    return false;
+  }
+  // Flags --memory-budget should be a size and only be used when applying matchers locally
+  uint64_t memoryBudget = 0;
+  if (!args.memoryBudget.empty() &&
+      (!ParseMemorySize(args.memoryBudget, memoryBudget) || memoryBudget == 0 ||
+       args.matchers.empty() || !args.connect.empty())) {
+    errmsg = "Options --memory-budget should be a size such as 16G and used with --matchers";
+    return false;
+  }
+  // Flags --load-matchers should be used with --matchers, --display or --server
+  if (!args.loadMatchers.empty() && args.matchers.empty() && !args.display &&
+      args.server.empty()) {
+    errmsg = "Options --load-matchers should be used with --matchers, --display or --server";
+    return false;
+  }
+  // Flags --query prints the matches, thus it cannot be run by a server or incrementally
+  if (!args.query.empty() && (!args.connect.empty() || args.incremental)) {
+    errmsg = "Options --query cannot be used with --connect or --incremental";
+    return false;
+  }
+  // Flags --find-index replaces the output file and is written locally
+  if (!args.findIndex.empty() && (args.matchers.empty() || !args.outputFile.empty() ||
+                                  !args.connect.empty() || args.incremental || args.watch)) {
+    errmsg = "Options --find-index should be used with --matchers and without --output, "
+        "--connect, --incremental or --watch";
+    return false;
+  }
+  // Flags --count-only replaces the output file and is run locally
+  if (args.countOnly && (args.matchers.empty() || !args.outputFile.empty() ||
+                         !args.findIndex.empty() || !args.connect.empty() ||
+                         args.incremental || args.watch)) {
+    errmsg = "Options --count-only should be used with --matchers and without --output, "
+        "--find-index, --connect, --incremental or --watch";
+    return false;
+  }
+  // Flags --sample should be a fraction in (0, 1] and only be used when processing files locally
+  if (args.sample != 0 && (!(args.sample > 0 && args.sample <= 1) || args.matchers.empty() ||
+                           !args.connect.empty() || args.incremental || args.watch)) {
+    errmsg = "Options --sample should be a fraction such as 0.02 and used with --matchers";
+    return false;
+  }
+  // Flags --max-matches should be positive and only be used when processing all the files locally
+  if (args.maxMatches != 0 && (args.maxMatches < 0 || args.matchers.empty() ||
+                               !args.connect.empty() || args.incremental || args.watch ||
+                               args.sample != 0)) {
+    errmsg = "Options --max-matches should be a positive number and used with --matchers";
+    return false;
+  }
+  // Flags --index-counts should be mutually exclusive with the rest options
+  if (!args.indexCounts.empty() && flagsum > 1) {
+    errmsg = "Options --index-counts should be mutually exclusive with the rest options";
+    return false;
+  }
   // option --output should be a file with yaml extension
   if (!args.outputFile.empty() && llvm::sys::path::extension(args.outputFile) != ".yaml") {
     errmsg = "Output file extension is not yaml";
@@ -198,5 +432,16 @@ bool ValidateCommandLineArgs(const CommandLineArgs& args, const std::vector<std:
     }
   }
 
+  // matcher arguments should be accepted by the options of the matchers
+  try {
+    ParseMatcherOptions(args.matchers, matcherArgs);
+  } catch (CommandLineOptionException& e) {
+    errmsg = e.what();
+    return false;
+  } catch (cxxopts::OptionException& e) {
+    errmsg = e.what();
+    return false;
+  }
+
   return true;
 }
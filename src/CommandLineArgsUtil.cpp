@@ -23,6 +23,7 @@
 */
 
 #include "CommandLineArgsUtil.hpp"
+#include "CoreUtil.hpp"
 
 #include <algorithm>
 #include <cstring>
@@ -71,3 +72,22 @@ std::vector<std::vector<std::string> > GetMatcherArgs(const std::vector<std::str
 
   return strippedArgs;
 }
+
+std::vector<std::string> MakePathArgsAbsolute(std::vector<std::string> args,
+                                              const std::vector<std::string>& pathOptions) {
+  for (size_t i = 0; i < args.size(); ++i) {
+    for (const auto& option : pathOptions) {
+      // --option path or --option=path
+      if (args[i] == option && i + 1 < args.size()) {
+        ++i;
+        args[i] = GetNormalizedPath(args[i]);
+        break;
+      }
+      if (args[i].compare(0, option.size() + 1, option + "=") == 0) {
+        args[i] = option + "=" + GetNormalizedPath(args[i].substr(option.size() + 1));
+        break;
+      }
+    }
+  }
+  return args;
+}
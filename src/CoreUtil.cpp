@@ -26,6 +26,7 @@
 #include "CodeXformException.hpp"
 #include "DiagnosticLogger.hpp"
 #include "CodeXformActionFactory.hpp"
+#include "SharedFileCache.hpp"
 
 #include <sstream>
 #include <fstream>
@@ -40,6 +41,7 @@
 #include "clang/Basic/DiagnosticOptions.h"
 #include "llvm/Support/raw_os_ostream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
 
 using namespace clang::tooling;
 using namespace clang;
@@ -76,6 +78,23 @@ int ExecCmd(const std::string& cmd, std::string& result) {
   return status;
 }
 
+std::string GetAbsolutePath(const std::string& dir, const std::string& file) {
+  SmallString<256> tmp_path(file);
+  if (!path::is_absolute(tmp_path)) {
+    tmp_path = dir;
+    path::append(tmp_path, file);
+  }
+  path::remove_dots(tmp_path, true);
+  return tmp_path.str().str();
+}
+
+std::string GetNormalizedPath(const std::string& file) {
+  SmallString<256> tmp_path(file);
+  fs::make_absolute(tmp_path);
+  path::remove_dots(tmp_path, true);
+  return tmp_path.str().str();
+}
+
 std::vector<std::string> ParseConfigFile(const std::string& fileName, const std::string& key)
 {
   // open file for reading
@@ -145,12 +164,7 @@ std::vector<std::string> ParseConfigFileForMatcherArgs(const std::string& fileNa
   return args;
 }
 
-int ProcessFiles(const CompilationDatabase& compilationDatabase,
-                 const std::vector<std::string>& inputFiles,
-                 const std::string& outputFile,
-                 const std::vector<std::string>& matchers,
-                 const std::vector<std::string>& matcherArgs,
-                 unsigned int numThreads)
+std::vector<std::pair<size_t, size_t> > PartitionFiles(size_t numFiles, unsigned int numThreads)
 {
   // We are trying to achieve a balance between two competing efficiency sources:
   // - Efficiency is gained by having the files processed by individual threads.  This is an
@@ -163,16 +177,39 @@ int ProcessFiles(const CompilationDatabase& compilationDatabase,
   // instance do several files.
   auto const hwConcurrency = std::max(
       1u, std::min(numThreads, std::max(4u, std::thread::hardware_concurrency())));
-  auto const numFiles = inputFiles.size();
 
   auto const filesPerCore = std::max(
       size_t(3), static_cast<size_t>(std::round(double(numFiles) / double(hwConcurrency))));
 
-  numThreads = ceil(double(numFiles) / double(filesPerCore));
+  std::vector<std::pair<size_t, size_t> > batches;
+  for (size_t beginRange = 0, endRange = std::min(numFiles, filesPerCore); beginRange < numFiles;
+       beginRange = endRange, endRange = std::min(numFiles, endRange + filesPerCore)) {
+    batches.emplace_back(beginRange, endRange);
+  }
+  return batches;
+}
+
+int ProcessFiles(const CompilationDatabase& compilationDatabase,
+                 const std::vector<std::string>& inputFiles,
+                 const std::string& outputFile,
+                 const std::vector<std::string>& matchers,
+                 const std::vector<std::string>& matcherArgs,
+                 unsigned int numThreads,
+                 const CodeXformOptions& options,
+                 IntrusiveRefCntPtr<vfs::FileSystem> baseFS)
+{
+  auto const numFiles = inputFiles.size();
+  auto const batches = PartitionFiles(numFiles, numThreads);
 
   std::vector<std::thread> threads;
   std::vector<std::future<std::tuple<int, std::string> > > futures;
 
+  // all the ClangTools share one file cache so that each header is read
+  // and stat'ed once per run instead of once per thread
+  if (!baseFS) {
+    baseFS = new SharedFileCache();
+  }
+
   // store current cwd
   // store current cwd
   SmallString<256> tmp_path;
@@ -180,17 +217,19 @@ int ProcessFiles(const CompilationDatabase& compilationDatabase,
   fs::current_path(tmp_path);
   cwd = tmp_path.str();
 
-  // loop through the list of files and process filesPerCore during each loop iteration.
-  for (size_t beginRange = 0, endRange = std::min(numFiles, filesPerCore); beginRange < numFiles;
-       beginRange = endRange, endRange = std::min(numFiles, endRange + filesPerCore)) {
+  // loop through the batches of files and process one batch during each loop iteration.
+  for (const auto& batch : batches) {
+    auto const beginRange = batch.first;
+    auto const endRange = batch.second;
 
     std::vector<std::string> fileSubset(inputFiles.begin() + beginRange,
                                         inputFiles.begin() + endRange);
 
     std::packaged_task<std::tuple<int, std::string>()> task(
-        [&compilationDatabase, &outputFile, &matchers, &matcherArgs, files = std::move(fileSubset)]()
+        [&compilationDatabase, &outputFile, &matchers, &matcherArgs, &options, &baseFS, files = std::move(fileSubset)]()
         {
-          clang::tooling::ClangTool tool(compilationDatabase, files);
+          clang::tooling::ClangTool tool(compilationDatabase, files,
+                                         std::make_shared<PCHContainerOperations>(), baseFS);
 
           // Disable RestoreWorkingDir in ClangTool::run to avoid threading issues.
           // Will manually restore it at the end
@@ -206,7 +245,8 @@ int ProcessFiles(const CompilationDatabase& compilationDatabase,
 
           //tool.setDiagnosticConsumer(new clang::IgnoringDiagConsumer());
 
-          const int toolStatus = tool.run(std::make_unique<CodeXformActionFactory>(outputFile, matchers, matcherArgs).get());
+          const int toolStatus = tool.run(std::make_unique<CodeXformActionFactory>(
+              outputFile, matchers, matcherArgs, options).get());
 
           return std::make_tuple(toolStatus, diagnostics.str());
         });
@@ -221,6 +261,16 @@ int ProcessFiles(const CompilationDatabase& compilationDatabase,
     }
   }
 
+  // join threads before collecting the results since a failed task throws
+  std::for_each(threads.begin(), threads.end(),
+                [](std::thread& t)
+                {
+                  if (t.joinable())
+                  {
+                    t.join();
+                  }
+                });
+
   // wait for all the futures to finish and return the number of failed tasks.
   auto ret = std::accumulate(futures.begin(), futures.end(), 0,
                              [](int sum, std::future<std::tuple<int, std::string> >& f)
@@ -237,16 +287,6 @@ int ProcessFiles(const CompilationDatabase& compilationDatabase,
                                return sum + nextStatus;
                              });
 
-  // join threads
-  std::for_each(threads.begin(), threads.end(),
-                [](std::thread& t)
-                {
-                  if (t.joinable())
-                  {
-                    t.join();
-                  }
-                });
-
   // restore cwd
   fs::set_current_path(cwd);
 
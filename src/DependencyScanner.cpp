@@ -0,0 +1,179 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "DependencyScanner.hpp"
+#include "CoreUtil.hpp"
+#include "cxxlog.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <thread>
+#include <future>
+#include <utility>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningService.h"
+#include "clang/Tooling/DependencyScanning/DependencyScanningWorker.h"
+#include "llvm/Support/Error.h"
+
+using namespace cxxlog;
+using namespace clang::tooling;
+using namespace clang::tooling::dependencies;
+using namespace llvm;
+
+namespace {
+
+typedef std::vector<std::pair<std::string, std::vector<std::string> > > DependencyList;
+
+} // end anonymous namespace
+
+std::vector<std::string> ParseDependencyFile(StringRef deps) {
+  std::vector<std::string> files;
+  // skip the target, i.e. "target: dep1 dep2 \"
+  auto pos = deps.find(':');
+  if (pos == StringRef::npos) {
+    return files;
+  }
+  deps = deps.drop_front(pos + 1);
+
+  std::string file;
+  auto flush = [&files, &file]() {
+    if (!file.empty()) {
+      files.push_back(std::move(file));
+      file.clear();
+    }
+  };
+
+  for (size_t i = 0; i < deps.size(); ++i) {
+    char c = deps[i];
+    char next = (i + 1 < deps.size()) ? deps[i + 1] : '\0';
+    if (c == '\\' && (next == '\n' || next == '\r')) {
+      // line continuation
+      flush();
+      ++i;
+      if (next == '\r' && i + 1 < deps.size() && deps[i + 1] == '\n') {
+        ++i;
+      }
+    } else if (c == '\\' && (next == ' ' || next == '#')) {
+      // escaped space or hash
+      file.push_back(next);
+      ++i;
+    } else if (c == '$' && next == '$') {
+      // escaped dollar sign
+      file.push_back('$');
+      ++i;
+    } else if (std::isspace(static_cast<unsigned char>(c))) {
+      flush();
+    } else {
+      file.push_back(c);
+    }
+  }
+  flush();
+
+  return files;
+}
+
+DependencyMap ScanDependencies(const CompilationDatabase& compilationDatabase,
+                               const std::vector<std::string>& inputFiles,
+                               unsigned int numThreads)
+{
+  // use the same partition as ProcessFiles. Each thread owns one
+  // DependencyScanningWorker while the minimized sources are cached in the
+  // service shared by all the workers.
+  auto const numFiles = inputFiles.size();
+
+  DependencyScanningService service(ScanningMode::MinimizedSourcePreprocessing);
+
+  std::vector<std::thread> threads;
+  std::vector<std::future<DependencyList> > futures;
+
+  for (const auto& batch : PartitionFiles(numFiles, numThreads)) {
+    auto const beginRange = batch.first;
+    auto const endRange = batch.second;
+
+    std::vector<std::string> fileSubset(inputFiles.begin() + beginRange,
+                                        inputFiles.begin() + endRange);
+
+    std::packaged_task<DependencyList()> task(
+        [&compilationDatabase, &service, files = std::move(fileSubset)]()
+        {
+          DependencyScanningWorker worker(service);
+          DependencyList deps;
+
+          for (const auto& file : files) {
+            auto commands = compilationDatabase.getCompileCommands(file);
+            if (commands.empty()) {
+              continue;
+            }
+            const std::string& dir = commands.front().Directory;
+            TRIVIAL_LOG(info) << "Scanning file: " << file << '\n';
+            auto depFile = worker.getDependencyFile(file, dir, compilationDatabase);
+            if (!depFile) {
+              TRIVIAL_LOG(warning) << "Failed to scan file: " << file << '\n'
+                                   << llvm::toString(depFile.takeError()) << '\n';
+              continue;
+            }
+
+            std::string source = GetAbsolutePath(dir, file);
+            std::vector<std::string> headers;
+            for (const auto& dep : ParseDependencyFile(*depFile)) {
+              auto header = GetAbsolutePath(dir, dep);
+              if (header != source) {
+                headers.push_back(std::move(header));
+              }
+            }
+            deps.emplace_back(file, std::move(headers));
+          }
+
+          return deps;
+        });
+    futures.push_back(task.get_future());
+    // let the current thread perform the last batch of files.
+    if (endRange < numFiles) {
+      threads.emplace_back(std::move(task));
+    }
+    else {
+      task();
+    }
+  }
+
+  // join threads before collecting the results since a failed task throws
+  std::for_each(threads.begin(), threads.end(),
+                [](std::thread& t)
+                {
+                  if (t.joinable())
+                  {
+                    t.join();
+                  }
+                });
+
+  DependencyMap dependencies;
+  for (auto& future : futures) {
+    for (auto& entry : future.get()) {
+      dependencies[entry.first] = std::move(entry.second);
+    }
+  }
+
+  return dependencies;
+}
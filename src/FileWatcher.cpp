@@ -0,0 +1,267 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "FileWatcher.hpp"
+#include "CoreUtil.hpp"
+#include "CodeXformException.hpp"
+#include "IncludeGraph.hpp"
+#include "IncrementalCache.hpp"
+#include "SharedFileCache.hpp"
+#include "cxxlog.hpp"
+
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace cxxlog;
+using namespace clang::tooling;
+using namespace llvm;
+using namespace llvm::sys;
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+    : mFD(inotify_init1(IN_CLOEXEC))
+{
+  if (mFD < 0) {
+    throw FileSystemException("Cannot initialize inotify: " + std::string(std::strerror(errno)));
+  }
+}
+
+FileWatcher::~FileWatcher() {
+  close(mFD);
+}
+
+void FileWatcher::Watch(const std::string& file) {
+  if (!mFiles.insert(file).second) {
+    return;
+  }
+  std::string dir = path::parent_path(file).str();
+  if (mDirIDs.count(dir)) {
+    return;
+  }
+  int id = inotify_add_watch(mFD, dir.c_str(),
+                             IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE);
+  if (id < 0) {
+    TRIVIAL_LOG(warning) << "Cannot watch directory: " << dir << '\n';
+    return;
+  }
+  mDirs[id] = dir;
+  mDirIDs[dir] = id;
+}
+
+std::vector<std::string> FileWatcher::WaitForChanges(int intervalMs) {
+  std::set<std::string> changes;
+  alignas(inotify_event) char buffer[65536];
+  // block until the first change, then collect the changes within the interval
+  int timeout = -1;
+  while (true) {
+    pollfd pfd = {mFD, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeout);
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready < 0) {
+      throw FileSystemException("Cannot wait for file changes: " + std::string(std::strerror(errno)));
+    }
+    if (ready == 0) {
+      break;
+    }
+    ssize_t size = read(mFD, buffer, sizeof(buffer));
+    if (size < 0) {
+      if (errno == EINTR) continue;
+      throw FileSystemException("Cannot read file changes: " + std::string(std::strerror(errno)));
+    }
+    for (char* ptr = buffer; ptr < buffer + size; ) {
+      auto event = reinterpret_cast<const inotify_event*>(ptr);
+      ptr += sizeof(inotify_event) + event->len;
+      auto dir = mDirs.find(event->wd);
+      if (event->len == 0 || dir == mDirs.end()) {
+        continue;
+      }
+      std::string file = dir->second + '/' + event->name;
+      if (mFiles.count(file)) {
+        changes.insert(std::move(file));
+      }
+    }
+    if (!changes.empty()) {
+      timeout = intervalMs;
+    }
+  }
+  return std::vector<std::string>(changes.begin(), changes.end());
+}
+
+#else
+
+FileWatcher::FileWatcher() {
+  throw FileSystemException("File watching is only supported on Linux");
+}
+
+FileWatcher::~FileWatcher() {}
+
+void FileWatcher::Watch(const std::string& file) {
+  mFiles.insert(file);
+}
+
+std::vector<std::string> FileWatcher::WaitForChanges(int) {
+  return std::vector<std::string>();
+}
+
+#endif
+
+bool FileWatcher::IsWatched(const std::string& file) const {
+  return mFiles.count(file);
+}
+
+void UpdateReplacementsByFile(std::map<std::string, std::string>& replacements,
+                              const std::vector<std::string>& files,
+                              const std::string& replacementsFile)
+{
+  // the replacements are keyed by the normalized main file, see CodeXformAction
+  for (const auto& file : files) {
+    replacements.erase(GetNormalizedPath(file));
+  }
+  for (auto& pair : ReadReplacementsByFile(replacementsFile)) {
+    replacements[pair.first] = std::move(pair.second);
+  }
+}
+
+void WatchFiles(const CompilationDatabase& compilationDatabase,
+                const std::vector<std::string>& inputFiles,
+                const std::string& outputFile,
+                const std::vector<std::string>& matchers,
+                const std::vector<std::string>& matcherArgs,
+                unsigned int numThreads,
+                const std::string& cacheDir,
+                const CodeXformOptions& options)
+{
+  IncludeGraph graph = LoadIncludeGraph(cacheDir, compilationDatabase, inputFiles, numThreads);
+  const std::set<std::string> inputSet(inputFiles.begin(), inputFiles.end());
+  // file contents stay cached between runs and are validated once per run
+  IntrusiveRefCntPtr<SharedFileCache> fileCache(new SharedFileCache());
+  // replacements of each processed file
+  std::map<std::string, std::string> replacements;
+
+  FileWatcher watcher;
+  auto watchFiles = [&watcher, &graph](const std::vector<std::string>& files) {
+    for (const auto& file : files) {
+      watcher.Watch(file);
+      for (const auto& header : graph.GetIncludedHeaders(file)) {
+        watcher.Watch(header);
+      }
+    }
+  };
+
+  SmallString<256> cwd;
+  fs::current_path(cwd);
+  auto processFiles = [&](const std::vector<std::string>& files) {
+    auto start = std::chrono::steady_clock::now();
+    SmallString<256> tmpFile;
+    if (fs::createTemporaryFile("clang-xform", "yaml", tmpFile)) {
+      throw FileSystemException("Cannot create temporary file");
+    }
+    try {
+      ProcessFiles(compilationDatabase, files, tmpFile.str().str(),
+                   matchers, matcherArgs, numThreads, options, fileCache);
+    }
+    catch (RunClangToolException& e) {
+      // keep watching so that the error can be fixed
+      std::cerr << e.what() << '\n';
+      fs::set_current_path(cwd);
+    }
+
+    UpdateReplacementsByFile(replacements, files, tmpFile.str().str());
+    fs::remove(tmpFile);
+
+    // replace the output file at once so that readers never see a partial file
+    std::string partialFile = outputFile + ".partial";
+    {
+      std::error_code EC;
+      raw_fd_ostream OS(partialFile, EC, fs::F_Text);
+      if (EC) {
+        throw FileSystemException("Cannot open file: " + partialFile);
+      }
+      for (const auto& pair : replacements) {
+        OS << pair.second;
+      }
+    }
+    if (fs::rename(partialFile, outputFile)) {
+      throw FileSystemException("Cannot write file: " + outputFile);
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Processed " << files.size() << " files in " << elapsed << " ms, "
+              << replacements.size() << " files have replacements in " << outputFile << '\n';
+  };
+
+  // watch before processing so that modifications during the first run are noticed
+  watchFiles(inputFiles);
+  processFiles(inputFiles);
+
+  while (true) {
+    std::cout << "Watching " << inputFiles.size() << " files for changes..." << '\n';
+    auto changes = watcher.WaitForChanges();
+    std::set<std::string> affectedSet;
+    for (const auto& file : changes) {
+      TRIVIAL_LOG(info) << "File changed: " << file << '\n';
+      if (inputSet.count(file)) {
+        affectedSet.insert(file);
+      }
+      for (const auto& includer : graph.GetIncludingFiles(file)) {
+        if (inputSet.count(includer)) {
+          affectedSet.insert(includer);
+        }
+      }
+    }
+    if (affectedSet.empty()) {
+      continue;
+    }
+
+    std::vector<std::string> affectedFiles(affectedSet.begin(), affectedSet.end());
+    // the affected files may include different headers now
+    if (graph.Update(compilationDatabase, affectedFiles, numThreads) > 0) {
+      fs::create_directories(cacheDir);
+      graph.Save(GetIncludeGraphFile(cacheDir));
+    }
+    watchFiles(affectedFiles);
+    fileCache->NewGeneration();
+    processFiles(affectedFiles);
+  }
+}
@@ -0,0 +1,315 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "FindIndex.hpp"
+#include "CodeXformException.hpp"
+
+#include <iomanip>
+#include <limits>
+
+#include "llvm/Support/Path.h"
+
+using namespace llvm;
+
+namespace {
+
+const char kFindIndexHeader[] = "clang-xform find index v1\n";
+constexpr size_t kFindIndexHeaderSize = sizeof(kFindIndexHeader) - 1;
+
+// Each block is laid out as
+//   uint32_t numHits, numMatchers, numFiles, namesBytes
+//   uint64_t snippetsBytes
+//   matcher and file names, each terminated by '\0'
+//   uint32_t matcher, file, offset, line, column and snippet end columns
+//   snippets
+// integers are stored in the byte order of the writing machine
+struct BlockHeader {
+  uint32_t numHits;
+  uint32_t numMatchers;
+  uint32_t numFiles;
+  uint32_t namesBytes;
+  uint64_t snippetsBytes;
+};
+
+template <typename T>
+void WriteColumn(std::ofstream& ofs, const std::vector<T>& column) {
+  ofs.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+// reads the blocks of an index file
+class FindIndexReader {
+ public:
+  explicit FindIndexReader(const std::string& file)
+      : mFile(file),
+        mIfs(file, std::ios::binary)
+  {
+    char header[kFindIndexHeaderSize];
+    if (!mIfs.good()) {
+      throw FileSystemException("Cannot open file: " + mFile);
+    }
+    if (!mIfs.read(header, kFindIndexHeaderSize) ||
+        std::string(header, kFindIndexHeaderSize) != kFindIndexHeader) {
+      Fail();
+    }
+  }
+
+  // read the header and the name tables of the next block.
+  // return false at the end of the file
+  bool Next() {
+    if (mIfs.peek() == std::ifstream::traits_type::eof()) {
+      return false;
+    }
+    if (!mIfs.read(reinterpret_cast<char*>(&mHeader), sizeof(mHeader))) {
+      Fail();
+    }
+    std::string names(mHeader.namesBytes, '\0');
+    if (!mIfs.read(&names[0], names.size())) {
+      Fail();
+    }
+    mMatchers.clear();
+    mFiles.clear();
+    size_t begin = 0;
+    while (begin < names.size()) {
+      size_t end = names.find('\0', begin);
+      if (end == std::string::npos) {
+        Fail();
+      }
+      auto& table = mMatchers.size() < mHeader.numMatchers ? mMatchers : mFiles;
+      table.push_back(names.substr(begin, end - begin));
+      begin = end + 1;
+    }
+    if (mMatchers.size() != mHeader.numMatchers || mFiles.size() != mHeader.numFiles) {
+      Fail();
+    }
+    mNumColumnsRead = 0;
+    return true;
+  }
+
+  // read the next column of the current block, validating ids against the given table size
+  std::vector<uint32_t> ReadColumn(size_t limit = std::numeric_limits<size_t>::max()) {
+    std::vector<uint32_t> column(mHeader.numHits);
+    if (!mIfs.read(reinterpret_cast<char*>(column.data()), column.size() * sizeof(uint32_t))) {
+      Fail();
+    }
+    for (auto value : column) {
+      if (value >= limit) {
+        Fail();
+      }
+    }
+    ++mNumColumnsRead;
+    return column;
+  }
+
+  std::string ReadSnippets() {
+    std::string snippets(mHeader.snippetsBytes, '\0');
+    if (!mIfs.read(&snippets[0], snippets.size())) {
+      Fail();
+    }
+    return snippets;
+  }
+
+  // skip the remaining columns and the snippets of the current block
+  void SkipBlock() {
+    std::streamoff bytes = static_cast<std::streamoff>(kNumColumns - mNumColumnsRead) *
+        mHeader.numHits * sizeof(uint32_t) + mHeader.snippetsBytes;
+    if (!mIfs.seekg(bytes, std::ios::cur)) {
+      Fail();
+    }
+  }
+
+  const BlockHeader& Header() const {
+    return mHeader;
+  }
+
+  const std::vector<std::string>& Matchers() const {
+    return mMatchers;
+  }
+
+  const std::vector<std::string>& Files() const {
+    return mFiles;
+  }
+
+  [[noreturn]] void Fail() const {
+    throw FileSystemException("Invalid find index file: " + mFile);
+  }
+
+ private:
+  static constexpr size_t kNumColumns = 6;
+
+  std::string mFile;
+  std::ifstream mIfs;
+  BlockHeader mHeader;
+  std::vector<std::string> mMatchers;
+  std::vector<std::string> mFiles;
+  size_t mNumColumnsRead = 0;
+};
+
+} // end anonymous namespace
+
+uint32_t FindIndexBlock::Intern(const std::string& name, std::vector<std::string>& names,
+                                std::unordered_map<std::string, uint32_t>& ids) {
+  auto result = ids.emplace(name, static_cast<uint32_t>(names.size()));
+  if (result.second) {
+    names.push_back(name);
+  }
+  return result.first->second;
+}
+
+void FindIndexBlock::Add(const std::string& matcher, const std::string& file, uint32_t offset,
+                         uint32_t line, uint32_t column, const std::string& snippet) {
+  mMatcherColumn.push_back(Intern(matcher, mMatchers, mMatcherIDs));
+  mFileColumn.push_back(Intern(file, mFiles, mFileIDs));
+  mOffsetColumn.push_back(offset);
+  mLineColumn.push_back(line);
+  mColumnColumn.push_back(column);
+  mSnippets += snippet;
+  mSnippetEnds.push_back(static_cast<uint32_t>(mSnippets.size()));
+}
+
+void FindIndexBlock::clear() {
+  *this = FindIndexBlock();
+}
+
+FindIndex::FindIndex(const std::string& file)
+    : mFile(file),
+      mOfs(file, std::ios::binary | std::ios::trunc)
+{
+  if (!mOfs.good() || !mOfs.write(kFindIndexHeader, kFindIndexHeaderSize).flush()) {
+    throw FileSystemException("Cannot write file: " + mFile);
+  }
+}
+
+void FindIndex::Append(FindIndexBlock& block) {
+  if (block.empty()) {
+    return;
+  }
+  std::string names;
+  for (const auto& name : block.mMatchers) {
+    names += name;
+    names += '\0';
+  }
+  for (const auto& name : block.mFiles) {
+    names += name;
+    names += '\0';
+  }
+  BlockHeader header = {static_cast<uint32_t>(block.size()),
+                        static_cast<uint32_t>(block.mMatchers.size()),
+                        static_cast<uint32_t>(block.mFiles.size()),
+                        static_cast<uint32_t>(names.size()),
+                        block.mSnippets.size()};
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mOfs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    mOfs.write(names.data(), names.size());
+    WriteColumn(mOfs, block.mMatcherColumn);
+    WriteColumn(mOfs, block.mFileColumn);
+    WriteColumn(mOfs, block.mOffsetColumn);
+    WriteColumn(mOfs, block.mLineColumn);
+    WriteColumn(mOfs, block.mColumnColumn);
+    WriteColumn(mOfs, block.mSnippetEnds);
+    mOfs.write(block.mSnippets.data(), block.mSnippets.size());
+    // complete blocks remain readable if the run is interrupted
+    if (!mOfs.flush()) {
+      throw FileSystemException("Cannot write file: " + mFile);
+    }
+  }
+  mSize += block.size();
+  block.clear();
+}
+
+void ReadFindIndex(const std::string& file, const std::function<void(const FindHit&)>& fn) {
+  FindIndexReader reader(file);
+  while (reader.Next()) {
+    const auto& matchers = reader.Matchers();
+    const auto& files = reader.Files();
+    auto matcherColumn = reader.ReadColumn(matchers.size());
+    auto fileColumn = reader.ReadColumn(files.size());
+    auto offsetColumn = reader.ReadColumn();
+    auto lineColumn = reader.ReadColumn();
+    auto columnColumn = reader.ReadColumn();
+    auto snippetEnds = reader.ReadColumn(reader.Header().snippetsBytes + 1);
+    std::string snippets = reader.ReadSnippets();
+
+    FindHit hit;
+    uint32_t snippetBegin = 0;
+    for (size_t i = 0; i < matcherColumn.size(); ++i) {
+      if (snippetEnds[i] < snippetBegin) {
+        reader.Fail();
+      }
+      hit.matcher = matchers[matcherColumn[i]];
+      hit.file = files[fileColumn[i]];
+      hit.offset = offsetColumn[i];
+      hit.line = lineColumn[i];
+      hit.column = columnColumn[i];
+      hit.snippet = snippets.substr(snippetBegin, snippetEnds[i] - snippetBegin);
+      snippetBegin = snippetEnds[i];
+      fn(hit);
+    }
+  }
+}
+
+FindIndexCounts CountFindIndex(const std::string& file) {
+  FindIndexCounts counts;
+  FindIndexReader reader(file);
+  while (reader.Next()) {
+    const auto& matchers = reader.Matchers();
+    const auto& files = reader.Files();
+    // count per id in the block before looking up the names
+    std::vector<uint64_t> matcherCounts(matchers.size());
+    for (auto id : reader.ReadColumn(matchers.size())) {
+      ++matcherCounts[id];
+    }
+    std::vector<uint64_t> fileCounts(files.size());
+    for (auto id : reader.ReadColumn(files.size())) {
+      ++fileCounts[id];
+    }
+    reader.SkipBlock();
+
+    counts.total += reader.Header().numHits;
+    for (size_t i = 0; i < matchers.size(); ++i) {
+      counts.matchers[matchers[i]] += matcherCounts[i];
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+      counts.files[files[i]] += fileCounts[i];
+    }
+  }
+  for (const auto& pair : counts.files) {
+    counts.directories[sys::path::parent_path(pair.first).str()] += pair.second;
+  }
+  return counts;
+}
+
+void PrintFindIndexCounts(const FindIndexCounts& counts, std::ostream& os) {
+  os << '\n' << "Hits: " << counts.total << '\n';
+
+  os << '\n' << "Hits per matcher:" << "\n\n";
+  for (const auto& pair : counts.matchers) {
+    os << std::setw(10) << pair.second << "  " << pair.first << '\n';
+  }
+
+  os << '\n' << "Hits per directory:" << "\n\n";
+  for (const auto& pair : counts.directories) {
+    os << std::setw(10) << pair.second << "  " << pair.first << '\n';
+  }
+}
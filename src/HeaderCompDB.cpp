@@ -0,0 +1,192 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "HeaderCompDB.hpp"
+#include "CoreUtil.hpp"
+#include "cxxlog.hpp"
+#include "CodeXformException.hpp"
+
+#include <set>
+#include <tuple>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace cxxlog;
+using namespace clang::tooling;
+using namespace llvm;
+using namespace llvm::sys;
+
+namespace {
+
+// (same stem, number of common directories, negative number of included headers)
+typedef std::tuple<bool, size_t, long> FitScore;
+
+// number of leading directories shared by the two given files
+size_t CountCommonDirectories(StringRef file1, StringRef file2) {
+  StringRef dir1 = path::parent_path(file1);
+  StringRef dir2 = path::parent_path(file2);
+  size_t count = 0;
+  for (auto it1 = path::begin(dir1), it2 = path::begin(dir2);
+       it1 != path::end(dir1) && it2 != path::end(dir2) && *it1 == *it2;
+       ++it1, ++it2) {
+    ++count;
+  }
+  return count;
+}
+
+// rewrite the compile command of a source file to compile the given header
+std::vector<std::string> MakeHeaderCommandLine(const CompileCommand& command,
+                                               const std::string& header) {
+  std::string source = GetAbsolutePath(command.Directory, command.Filename);
+  std::vector<std::string> args;
+  for (size_t i = 0; i < command.CommandLine.size(); ++i) {
+    const auto& arg = command.CommandLine[i];
+    if (arg == "-o") {
+      // header does not produce an object file
+      ++i;
+      continue;
+    }
+    if (i > 0 && !StringRef(arg).startswith("-") &&
+        GetAbsolutePath(command.Directory, arg) == source) {
+      args.push_back(header);
+      continue;
+    }
+    args.push_back(arg);
+  }
+  return args;
+}
+
+} // end anonymous namespace
+
+bool IsHeaderFile(const std::string& file) {
+  auto ext = path::extension(file);
+  return ext == ".h" || ext == ".hh" || ext == ".hpp" || ext == ".hxx";
+}
+
+std::map<std::string, std::string> AssignHeadersToSources(const DependencyMap& dependencies,
+                                                          const std::string& rootDir)
+{
+  std::map<std::string, std::pair<FitScore, std::string> > bestFits;
+  std::string prefix = rootDir;
+  if (!prefix.empty() && !path::is_separator(prefix.back())) {
+    prefix.push_back(path::get_separator().front());
+  }
+
+  for (const auto& entry : dependencies) {
+    const auto& source = entry.first;
+    auto stem = path::stem(source);
+    for (const auto& header : entry.second) {
+      // only headers under the root directory are refactored
+      if (!StringRef(header).startswith(prefix)) {
+        continue;
+      }
+      FitScore score(path::stem(header) == stem,
+                     CountCommonDirectories(source, header),
+                     -static_cast<long>(entry.second.size()));
+      auto iter = bestFits.find(header);
+      if (iter == bestFits.end()) {
+        bestFits.emplace(header, std::make_pair(score, source));
+      } else if (iter->second.first < score) {
+        iter->second = std::make_pair(score, source);
+      }
+    }
+  }
+
+  std::map<std::string, std::string> headerMap;
+  for (auto& pair : bestFits) {
+    headerMap.emplace(pair.first, std::move(pair.second.second));
+  }
+  return headerMap;
+}
+
+size_t GenerateHeaderCompDB(const std::string& jsonFile,
+                            const CompilationDatabase& compilationDatabase,
+                            unsigned int numThreads)
+{
+  // headers which already have compile commands are kept as is
+  std::vector<std::string> sources;
+  std::set<std::string> headers;
+  for (auto& file : compilationDatabase.getAllFiles()) {
+    if (IsHeaderFile(file)) {
+      headers.insert(std::move(file));
+    } else {
+      sources.push_back(std::move(file));
+    }
+  }
+
+  auto dependencies = ScanDependencies(compilationDatabase, sources, numThreads);
+  auto headerMap = AssignHeadersToSources(dependencies, path::parent_path(jsonFile).str());
+
+  // read the original json file and append new compile commands
+  auto buffer = MemoryBuffer::getFile(jsonFile);
+  if (std::error_code BufferError = buffer.getError()) {
+    throw FileSystemException("Cannot open file: " + jsonFile + ": " + BufferError.message());
+  }
+  auto json = json::parse(buffer.get()->getBuffer());
+  if (!json) {
+    throw FileSystemException("Cannot parse file: " + jsonFile + ": " +
+                              llvm::toString(json.takeError()));
+  }
+  auto* entries = json->getAsArray();
+  if (!entries) {
+    throw FileSystemException("Invalid json compilation database: " + jsonFile);
+  }
+
+  size_t count = 0;
+  for (const auto& pair : headerMap) {
+    if (headers.count(pair.first)) {
+      continue;
+    }
+    auto commands = compilationDatabase.getCompileCommands(pair.second);
+    if (commands.empty()) {
+      continue;
+    }
+    const auto& command = commands.front();
+    json::Array arguments;
+    for (auto& arg : MakeHeaderCommandLine(command, pair.first)) {
+      arguments.push_back(std::move(arg));
+    }
+    entries->push_back(json::Object{{"directory", command.Directory},
+                                    {"file", pair.first},
+                                    {"arguments", std::move(arguments)}});
+    TRIVIAL_LOG(info) << "Header: " << pair.first << " uses compile command of " << pair.second << '\n';
+    ++count;
+  }
+
+  // rewrite the json file
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(jsonFile, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    throw FileSystemException("Cannot write file: " + jsonFile + ": " + EC.message());
+  }
+  OS << formatv("{0:4}", *json) << '\n';
+
+  return count;
+}
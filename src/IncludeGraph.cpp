@@ -0,0 +1,304 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "IncludeGraph.hpp"
+#include "DependencyScanner.hpp"
+#include "CoreUtil.hpp"
+#include "CodeXformException.hpp"
+#include "cxxlog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/Support/FileSystem.h"
+
+using namespace cxxlog;
+using namespace clang::tooling;
+using namespace llvm;
+using namespace llvm::sys;
+
+namespace {
+
+const std::string kIncludeGraphHeader = "clang-xform include graph v1";
+
+// file systems may truncate modification times to seconds
+constexpr int64_t kTimestampMargin = 1000000000;
+
+int64_t GetCurrentTime() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// return -1 if the file does not exist
+int64_t GetModificationTime(const std::string& file) {
+  fs::file_status status;
+  if (fs::status(file, status)) {
+    return -1;
+  }
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      status.getLastModificationTime().time_since_epoch()).count();
+}
+
+} // end anonymous namespace
+
+bool IncludeGraph::Load(const std::string& file) {
+  std::ifstream ifs(file);
+  std::string line;
+  if (!ifs.good() || !std::getline(ifs, line) || line != kIncludeGraphHeader) {
+    return false;
+  }
+
+  // F <path>
+  // T <file id> <timestamp> <header id> <header id> ...
+  std::vector<std::string> paths;
+  std::map<unsigned, Entry> entries;
+  while (std::getline(ifs, line)) {
+    if (line.size() < 2) {
+      continue;
+    }
+    if (line[0] == 'F') {
+      paths.push_back(line.substr(2));
+    } else if (line[0] == 'T') {
+      std::istringstream is_line(line.substr(2));
+      unsigned id;
+      Entry entry;
+      is_line >> id >> entry.timestamp;
+      unsigned header;
+      while (is_line >> header) {
+        entry.headers.push_back(header);
+      }
+      entries[id] = std::move(entry);
+    }
+  }
+
+  // validate file ids
+  for (const auto& pair : entries) {
+    if (pair.first >= paths.size() ||
+        std::any_of(pair.second.headers.begin(), pair.second.headers.end(),
+                    [&paths](unsigned id) {return id >= paths.size();})) {
+      return false;
+    }
+  }
+
+  *this = IncludeGraph();
+  for (const auto& path : paths) {
+    GetPathID(path);
+  }
+  for (auto& pair : entries) {
+    for (auto header : pair.second.headers) {
+      mIncluders[header].insert(pair.first);
+    }
+    mEntries.emplace(pair.first, std::move(pair.second));
+  }
+  return true;
+}
+
+void IncludeGraph::Save(const std::string& file) const {
+  std::ofstream ofs(file);
+  if (!ofs.good()) {
+    throw FileSystemException("Cannot open file: " + file);
+  }
+  ofs << kIncludeGraphHeader << '\n';
+  for (const auto& path : mPaths) {
+    ofs << "F " << path << '\n';
+  }
+  for (const auto& pair : mEntries) {
+    ofs << "T " << pair.first << ' ' << pair.second.timestamp;
+    for (auto header : pair.second.headers) {
+      ofs << ' ' << header;
+    }
+    ofs << '\n';
+  }
+}
+
+size_t IncludeGraph::Update(const CompilationDatabase& compilationDatabase,
+                            const std::vector<std::string>& files,
+                            unsigned int numThreads)
+{
+  // stat each file at most once
+  std::unordered_map<unsigned, int64_t> mtimes;
+  auto isModified = [this, &mtimes](unsigned id, int64_t timestamp) {
+    auto iter = mtimes.find(id);
+    if (iter == mtimes.end()) {
+      iter = mtimes.emplace(id, GetModificationTime(mPaths[id])).first;
+    }
+    return iter->second < 0 || iter->second + kTimestampMargin > timestamp;
+  };
+
+  std::vector<std::string> staleFiles;
+  for (const auto& file : files) {
+    auto iter = mPathIDs.find(file);
+    auto entry = (iter == mPathIDs.end()) ? mEntries.end() : mEntries.find(iter->second);
+    if (entry == mEntries.end() ||
+        isModified(entry->first, entry->second.timestamp) ||
+        std::any_of(entry->second.headers.begin(), entry->second.headers.end(),
+                    [&isModified, &entry](unsigned id)
+                    {return isModified(id, entry->second.timestamp);})) {
+      staleFiles.push_back(file);
+    }
+  }
+
+  if (staleFiles.empty()) {
+    return 0;
+  }
+
+  // files modified during the scan will be rescanned next time
+  int64_t timestamp = GetCurrentTime();
+  auto dependencies = ScanDependencies(compilationDatabase, staleFiles, numThreads);
+  for (const auto& pair : dependencies) {
+    SetIncludedHeaders(pair.first, pair.second, timestamp);
+  }
+
+  return staleFiles.size();
+}
+
+void IncludeGraph::SetIncludedHeaders(const std::string& file,
+                                      const std::vector<std::string>& headers,
+                                      int64_t timestamp)
+{
+  unsigned id = GetPathID(file);
+  Entry& entry = mEntries[id];
+  // remove stale reverse edges
+  for (auto header : entry.headers) {
+    mIncluders[header].erase(id);
+  }
+
+  entry.timestamp = timestamp;
+  entry.headers.clear();
+  entry.headers.reserve(headers.size());
+  for (const auto& header : headers) {
+    unsigned headerID = GetPathID(header);
+    entry.headers.push_back(headerID);
+    mIncluders[headerID].insert(id);
+  }
+}
+
+bool IncludeGraph::HasFile(const std::string& file) const {
+  auto iter = mPathIDs.find(file);
+  return iter != mPathIDs.end() && mEntries.count(iter->second);
+}
+
+std::vector<std::string> IncludeGraph::GetFiles() const {
+  std::vector<std::string> files;
+  files.reserve(mEntries.size());
+  for (const auto& pair : mEntries) {
+    files.push_back(mPaths[pair.first]);
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+std::vector<std::string> IncludeGraph::GetIncludedHeaders(const std::string& file) const {
+  auto iter = mPathIDs.find(file);
+  if (iter == mPathIDs.end()) {
+    return std::vector<std::string>();
+  }
+  auto entry = mEntries.find(iter->second);
+  if (entry == mEntries.end()) {
+    return std::vector<std::string>();
+  }
+  return GetPaths(entry->second.headers);
+}
+
+std::vector<std::string> IncludeGraph::GetIncludingFiles(const std::string& header) const {
+  auto iter = mPathIDs.find(header);
+  if (iter == mPathIDs.end()) {
+    return std::vector<std::string>();
+  }
+  auto includers = mIncluders.find(iter->second);
+  if (includers == mIncluders.end()) {
+    return std::vector<std::string>();
+  }
+  return GetPaths(std::vector<unsigned>(includers->second.begin(), includers->second.end()));
+}
+
+unsigned IncludeGraph::GetPathID(const std::string& path) {
+  auto iter = mPathIDs.find(path);
+  if (iter != mPathIDs.end()) {
+    return iter->second;
+  }
+  unsigned id = mPaths.size();
+  mPaths.push_back(path);
+  mPathIDs.emplace(path, id);
+  return id;
+}
+
+std::vector<std::string> IncludeGraph::GetPaths(const std::vector<unsigned>& ids) const {
+  std::vector<std::string> paths;
+  paths.reserve(ids.size());
+  for (auto id : ids) {
+    paths.push_back(mPaths[id]);
+  }
+  std::sort(paths.begin(), paths.end());
+  return paths;
+}
+
+std::string GetIncludeGraphFile(const std::string& cacheDir) {
+  return cacheDir + "/include-graph.txt";
+}
+
+IncludeGraph LoadIncludeGraph(const std::string& cacheDir,
+                              const CompilationDatabase& compilationDatabase,
+                              const std::vector<std::string>& files,
+                              unsigned int numThreads)
+{
+  std::string graphFile = GetIncludeGraphFile(cacheDir);
+  IncludeGraph graph;
+  graph.Load(graphFile);
+
+  auto numScanned = graph.Update(compilationDatabase, files, numThreads);
+  TRIVIAL_LOG(info) << "Include graph: " << numScanned << " of " << files.size()
+                    << " files rescanned" << '\n';
+  if (numScanned > 0) {
+    fs::create_directories(cacheDir);
+    graph.Save(graphFile);
+  }
+  return graph;
+}
+
+std::unordered_map<std::string, std::string>
+GetHeaderOwners(const IncludeGraph& graph, const std::vector<std::string>& files)
+{
+  // the number of headers reached approximates the cost of parsing a file
+  std::vector<std::pair<size_t, std::string> > costs;
+  costs.reserve(files.size());
+  for (const auto& file : files) {
+    // owners are compared with the normalized path of the main file
+    auto source = GetNormalizedPath(file);
+    costs.emplace_back(graph.GetIncludedHeaders(source).size(), std::move(source));
+  }
+  std::sort(costs.begin(), costs.end());
+
+  // visiting the cheapest files first, a header is owned by the first file reaching it
+  std::unordered_map<std::string, std::string> owners;
+  for (const auto& cost : costs) {
+    for (auto& header : graph.GetIncludedHeaders(cost.second)) {
+      owners.emplace(std::move(header), cost.second);
+    }
+  }
+  return owners;
+}
@@ -0,0 +1,451 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "IncrementalCache.hpp"
+#include "IncludeGraph.hpp"
+#include "CoreUtil.hpp"
+#include "CodeXformException.hpp"
+#include "MatcherFactory.hpp"
+#include "MatchCallbackBase.hpp"
+#include "MyReplacementsYaml.hpp"
+#include "cxxlog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <thread>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace cxxlog;
+using namespace clang::tooling;
+using namespace llvm;
+using namespace llvm::sys;
+
+namespace {
+
+const std::string kManifestHeader = "clang-xform manifest v1";
+
+// used to locate the executable
+int sExecutableAnchor;
+
+void eatDiagnostics(const SMDiagnostic &, void *) {}
+
+std::string FinalizeHash(MD5& hash) {
+  MD5::MD5Result result;
+  hash.final(result);
+  return result.digest().str().str();
+}
+
+// read "<hash> <path>" records into the given map
+bool ParseHashLine(const std::string& line, std::map<std::string, std::string>& hashes) {
+  auto pos = line.find(' ', 2);
+  if (pos == std::string::npos) {
+    return false;
+  }
+  hashes[line.substr(pos + 1)] = line.substr(2, pos - 2);
+  return true;
+}
+
+// append the cached replacements of the given files into the output file
+void AppendCachedReplacements(const std::string& cacheFile,
+                              const std::set<std::string>& files,
+                              const std::string& outputFile)
+{
+  auto replacements = ReadReplacementsByFile(cacheFile);
+  if (replacements.empty()) {
+    return;
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(outputFile, EC, fs::F_Append);
+  if (EC) {
+    throw FileSystemException("Cannot open file: " + outputFile);
+  }
+  for (const auto& pair : replacements) {
+    if (files.count(pair.first)) {
+      OS << pair.second;
+    }
+  }
+}
+
+// store the replacements of this run into the cache file, keeping the cached
+// replacements of the files not processed by this run if keepOthers is set
+void UpdateCachedReplacements(const std::string& cacheFile,
+                              const std::set<std::string>& files,
+                              const std::string& outputFile,
+                              bool keepOthers)
+{
+  std::map<std::string, std::string> replacements;
+  if (keepOthers) {
+    replacements = ReadReplacementsByFile(cacheFile);
+  }
+
+  std::string tmpFile = cacheFile + ".tmp";
+  if (fs::copy_file(outputFile, tmpFile)) {
+    throw FileSystemException("Cannot write file: " + tmpFile);
+  }
+  {
+    std::error_code EC;
+    raw_fd_ostream OS(tmpFile, EC, fs::F_Append);
+    if (EC) {
+      throw FileSystemException("Cannot open file: " + tmpFile);
+    }
+    for (const auto& pair : replacements) {
+      if (!files.count(pair.first)) {
+        OS << pair.second;
+      }
+    }
+  }
+  if (fs::rename(tmpFile, cacheFile)) {
+    throw FileSystemException("Cannot write file: " + cacheFile);
+  }
+}
+
+} // end anonymous namespace
+
+bool RunManifest::Load(const std::string& file) {
+  std::ifstream ifs(file);
+  std::string line;
+  if (!ifs.good() || !std::getline(ifs, line) || line != kManifestHeader) {
+    return false;
+  }
+
+  // S <signature>
+  // H <content hash> <path>
+  // C <compile command hash> <path>
+  RunManifest manifest;
+  while (std::getline(ifs, line)) {
+    if (line.size() < 2) {
+      continue;
+    }
+    if (line[0] == 'S') {
+      manifest.mSignature = line.substr(2);
+    } else if (line[0] == 'H') {
+      if (!ParseHashLine(line, manifest.mFileHashes)) return false;
+    } else if (line[0] == 'C') {
+      if (!ParseHashLine(line, manifest.mCommandHashes)) return false;
+    }
+  }
+
+  *this = std::move(manifest);
+  return true;
+}
+
+void RunManifest::Save(const std::string& file) const {
+  std::ofstream ofs(file);
+  if (!ofs.good()) {
+    throw FileSystemException("Cannot open file: " + file);
+  }
+  ofs << kManifestHeader << '\n';
+  ofs << "S " << mSignature << '\n';
+  for (const auto& pair : mFileHashes) {
+    ofs << "H " << pair.second << ' ' << pair.first << '\n';
+  }
+  for (const auto& pair : mCommandHashes) {
+    ofs << "C " << pair.second << ' ' << pair.first << '\n';
+  }
+}
+
+std::string RunManifest::GetFileHash(const std::string& file) const {
+  auto iter = mFileHashes.find(file);
+  return (iter == mFileHashes.end()) ? std::string() : iter->second;
+}
+
+void RunManifest::SetFileHash(const std::string& file, const std::string& hash) {
+  mFileHashes[file] = hash;
+}
+
+std::string RunManifest::GetCommandHash(const std::string& file) const {
+  auto iter = mCommandHashes.find(file);
+  return (iter == mCommandHashes.end()) ? std::string() : iter->second;
+}
+
+void RunManifest::SetCommandHash(const std::string& file, const std::string& hash) {
+  mCommandHashes[file] = hash;
+}
+
+std::vector<std::string> RunManifest::Merge(const RunManifest& previous,
+                                           const IncludeGraph& graph) {
+  std::vector<std::string> droppedFiles;
+  if (previous.mSignature != mSignature) {
+    return droppedFiles;
+  }
+  // a file of a previous run was processed with the inputs hashed then. drop
+  // it if this run hashed any of its inputs differently, or if its inputs are
+  // unknown, so that the next run processes it again
+  auto isChanged = [this, &previous](const std::string& file) {
+    auto hash = GetFileHash(file);
+    return !hash.empty() && hash != previous.GetFileHash(file);
+  };
+  for (const auto& pair : previous.mCommandHashes) {
+    const std::string& file = pair.first;
+    if (mCommandHashes.count(file)) {
+      continue;
+    }
+    auto headers = graph.GetIncludedHeaders(file);
+    if (!graph.HasFile(file) || isChanged(file) ||
+        std::any_of(headers.begin(), headers.end(), isChanged)) {
+      droppedFiles.push_back(file);
+    } else {
+      mCommandHashes.insert(pair);
+    }
+  }
+  // insert does not overwrite the hashes of this run
+  mFileHashes.insert(previous.mFileHashes.begin(), previous.mFileHashes.end());
+  return droppedFiles;
+}
+
+std::string HashFile(const std::string& file) {
+  ErrorOr<std::unique_ptr<MemoryBuffer> > buffer = MemoryBuffer::getFile(file);
+  if (!buffer) {
+    return std::string();
+  }
+  MD5 hash;
+  hash.update(buffer.get()->getBuffer());
+  return FinalizeHash(hash);
+}
+
+std::vector<std::string> HashFiles(const std::vector<std::string>& files,
+                                   unsigned int numThreads)
+{
+  std::vector<std::string> hashes(files.size());
+  numThreads = std::max(1u, std::min({numThreads,
+                                      std::max(4u, std::thread::hardware_concurrency()),
+                                      static_cast<unsigned int>(files.size())}));
+  // each thread hashes every numThreads-th file
+  auto hashSubset = [&files, &hashes, numThreads](unsigned int begin) {
+    for (size_t i = begin; i < files.size(); i += numThreads) {
+      hashes[i] = HashFile(files[i]);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < numThreads; ++i) {
+    threads.emplace_back(hashSubset, i);
+  }
+  hashSubset(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return hashes;
+}
+
+std::string HashCompileCommand(const CompilationDatabase& compilationDatabase,
+                               const std::string& file)
+{
+  auto commands = compilationDatabase.getCompileCommands(file);
+  if (commands.empty()) {
+    return std::string();
+  }
+  MD5 hash;
+  for (const auto& command : commands) {
+    hash.update(command.Directory);
+    hash.update(StringRef("\0", 1));
+    for (const auto& arg : command.CommandLine) {
+      hash.update(arg);
+      hash.update(StringRef("\0", 1));
+    }
+  }
+  return FinalizeHash(hash);
+}
+
+std::string GetRunSignature(const std::vector<std::string>& matchers,
+                            const std::vector<std::string>& matcherArgs,
+                            const CodeXformOptions& options)
+{
+  MD5 hash;
+  for (const auto& matcher : matchers) {
+    hash.update(matcher);
+    hash.update(StringRef("\0", 1));
+  }
+  hash.update(StringRef("--\0", 3));
+  for (const auto& arg : matcherArgs) {
+    hash.update(arg);
+    hash.update(StringRef("\0", 1));
+  }
+  hash.update(StringRef("--\0", 3));
+  for (const auto& option : EncodeOptions(options)) {
+    hash.update(option);
+    hash.update(StringRef("\0", 1));
+  }
+
+  // a rebuilt executable or plugin may generate different replacements
+  std::vector<std::string> binaries = MatcherFactory::Instance().getPlugins();
+  binaries.insert(binaries.begin(), fs::getMainExecutable("clang-xform", &sExecutableAnchor));
+  for (const auto& binary : binaries) {
+    fs::file_status status;
+    if (!fs::status(binary, status)) {
+      hash.update(binary);
+      hash.update(std::to_string(status.getSize()));
+      hash.update(std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          status.getLastModificationTime().time_since_epoch()).count()));
+    }
+  }
+  return FinalizeHash(hash);
+}
+
+std::vector<std::string> SelectAffectedFiles(const RunManifest& previous,
+                                             const RunManifest& current,
+                                             const IncludeGraph& graph,
+                                             const std::vector<std::string>& files)
+{
+  if (previous.GetSignature() != current.GetSignature()) {
+    return files;
+  }
+
+  auto isChanged = [&previous, &current](const std::string& file) {
+    auto hash = current.GetFileHash(file);
+    return hash.empty() || hash != previous.GetFileHash(file);
+  };
+
+  std::vector<std::string> affectedFiles;
+  for (const auto& file : files) {
+    auto command = current.GetCommandHash(file);
+    if (command.empty() || command != previous.GetCommandHash(file) || isChanged(file)) {
+      affectedFiles.push_back(file);
+      continue;
+    }
+    auto headers = graph.GetIncludedHeaders(file);
+    if (std::any_of(headers.begin(), headers.end(), isChanged)) {
+      affectedFiles.push_back(file);
+    }
+  }
+  return affectedFiles;
+}
+
+std::map<std::string, std::string> ReadReplacementsByFile(const std::string& file) {
+  std::map<std::string, std::string> replacements;
+  ErrorOr<std::unique_ptr<MemoryBuffer> > buffer = MemoryBuffer::getFile(file);
+  if (!buffer || buffer.get()->getBuffer().empty()) {
+    return replacements;
+  }
+
+  auto read = [&replacements](yaml::Input& YIn) {
+    if (YIn.error()) {
+      return;
+    }
+    TranslationUnitReplacements TUR;
+    YIn >> TUR;
+    if (YIn.error()) {
+      return;
+    }
+    std::string document;
+    raw_string_ostream OS(document);
+    yaml::Output YAML(OS);
+    YAML << TUR;
+    replacements[TUR.MainSourceFile] += OS.str();
+  };
+
+  yaml::Input YIn(buffer.get()->getBuffer(), nullptr, &eatDiagnostics);
+  read(YIn);
+  while (YIn.nextDocument()) {
+    read(YIn);
+  }
+  return replacements;
+}
+
+std::string GetManifestFile(const std::string& cacheDir) {
+  return cacheDir + "/manifest.txt";
+}
+
+std::string GetCachedReplacementsFile(const std::string& cacheDir) {
+  return cacheDir + "/replacements.yaml";
+}
+
+int ProcessFilesIncrementally(const CompilationDatabase& compilationDatabase,
+                              const std::vector<std::string>& inputFiles,
+                              const std::string& outputFile,
+                              const std::vector<std::string>& matchers,
+                              const std::vector<std::string>& matcherArgs,
+                              unsigned int numThreads,
+                              const std::string& cacheDir,
+                              const CodeXformOptions& options)
+{
+  IncludeGraph graph = LoadIncludeGraph(cacheDir, compilationDatabase, inputFiles, numThreads);
+
+  // hash the inputs of this run before processing them
+  RunManifest current;
+  current.SetSignature(GetRunSignature(matchers, matcherArgs, options));
+  std::set<std::string> fileSet(inputFiles.begin(), inputFiles.end());
+  for (const auto& file : inputFiles) {
+    current.SetCommandHash(file, HashCompileCommand(compilationDatabase, file));
+    auto headers = graph.GetIncludedHeaders(file);
+    fileSet.insert(headers.begin(), headers.end());
+  }
+  std::vector<std::string> allFiles(fileSet.begin(), fileSet.end());
+  auto hashes = HashFiles(allFiles, numThreads);
+  for (size_t i = 0; i < allFiles.size(); ++i) {
+    current.SetFileHash(allFiles[i], hashes[i]);
+  }
+
+  RunManifest previous;
+  std::string manifestFile = GetManifestFile(cacheDir);
+  std::string cacheFile = GetCachedReplacementsFile(cacheDir);
+  if (!previous.Load(manifestFile) || !fs::exists(cacheFile)) {
+    previous = RunManifest();
+  }
+
+  auto affectedFiles = SelectAffectedFiles(previous, current, graph, inputFiles);
+  TRIVIAL_LOG(info) << "Incremental: " << affectedFiles.size() << " of " << inputFiles.size()
+                    << " files affected" << '\n';
+
+  int status = 0;
+  if (!affectedFiles.empty()) {
+    status = ProcessFiles(compilationDatabase, affectedFiles, outputFile,
+                          matchers, matcherArgs, numThreads, options);
+  }
+
+  std::set<std::string> unaffectedFiles(inputFiles.begin(), inputFiles.end());
+  for (const auto& file : affectedFiles) {
+    unaffectedFiles.erase(file);
+  }
+  if (!unaffectedFiles.empty()) {
+    AppendCachedReplacements(cacheFile, unaffectedFiles, outputFile);
+  }
+
+  // keep the previous cache if any file failed to process. the files of
+  // previous runs which are not part of this run stay in the cache as long as
+  // the signature is unchanged
+  if (status == 0) {
+    bool keepOthers = (previous.GetSignature() == current.GetSignature());
+    // the cached replacements of the dropped files are stale
+    std::set<std::string> replacedFiles(inputFiles.begin(), inputFiles.end());
+    auto droppedFiles = current.Merge(previous, graph);
+    replacedFiles.insert(droppedFiles.begin(), droppedFiles.end());
+    fs::create_directories(cacheDir);
+    // the manifest is written last so that it never refers to a stale cache
+    fs::remove(manifestFile);
+    UpdateCachedReplacements(cacheFile, replacedFiles, outputFile, keepOthers);
+    current.Save(manifestFile);
+  }
+  return status;
+}
@@ -23,7 +23,18 @@
 */
 
 #include "MatchCallbackBase.hpp"
+#include "CommandLineArgsUtil.hpp"
+#include "FindIndex.hpp"
+#include "MatchLimit.hpp"
+#include "MatcherFactory.hpp"
+#include "ToolingUtil.hpp"
 
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "clang/Basic/SourceManager.h"
 #include "clang/Tooling/Inclusions/HeaderIncludes.h"
 #include "clang/Tooling/Inclusions/IncludeStyle.h"
 
@@ -31,6 +42,178 @@ using namespace llvm;
 using namespace clang;
 using namespace clang::tooling;
 
+namespace {
+
+// option tables parsed so far, keyed by the matcher arguments and options
+std::mutex optionTablesMutex;
+std::map<std::string, std::shared_ptr<const MatcherOptionTable> > optionTables;
+
+// create and parse the options of each instance of the given matchers, one
+// per separator --matcher-args-ID or one without arguments, and visit it.
+// stop and return false once the visitor returns false.
+// Throw CommandLineOptionException if a matcher is not registered
+bool ForEachMatcherInstance(const std::vector<std::string>& ids,
+                            const std::vector<std::string>& args,
+                            const std::function<bool(MatchCallbackBase&)>& visit) {
+  MatcherFactory& factory = MatcherFactory::Instance();
+  Replacements replacements;
+  for (const auto& id : ids) {
+    auto matcherArgs = GetMatcherArgs(args, id);
+    if (matcherArgs.empty()) {
+      matcherArgs.emplace_back();
+    }
+    for (auto& instanceArgs : matcherArgs) {
+      auto callback = factory.CreateMatchCallback(id, replacements, std::move(instanceArgs));
+      if (!callback) {
+        throw CommandLineOptionException("Matcher ID: " + id + " is not registered!");
+      }
+      callback->RegisterOptions();
+      callback->ParseOptions();
+      if (!visit(*callback)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // end of anonymous namespace
+
+void MatchCallbackBase::ParseOptions() {
+  if (mArgs.empty()) {
+    return;
+  }
+  std::string key;
+  for (const auto& arg : mArgs) {
+    key += arg;
+    key += '\0';
+  }
+  for (const auto& extractor : mExtractors) {
+    key += extractor.key;
+    key += '\0';
+    key += std::to_string(reinterpret_cast<std::uintptr_t>(extractor.type));
+    key += '\0';
+  }
+  {
+    std::lock_guard<std::mutex> lock(optionTablesMutex);
+    auto iter = optionTables.find(key);
+    if (iter != optionTables.end()) {
+      mTable = iter->second;
+      return;
+    }
+  }
+
+  int argc = static_cast<int>(mArgs.size());
+  std::vector<char*> cstrArgs;
+  cstrArgs.reserve(argc);
+  for (auto& s : mArgs) {
+    cstrArgs.push_back(const_cast<char*>(s.c_str()));
+  }
+  char** argv = &cstrArgs[0];
+  auto result = mOptions.parse(argc, argv);
+  auto table = std::make_shared<MatcherOptionTable>();
+  for (const auto& extractor : mExtractors) {
+    extractor.extract(result, extractor.key, *table);
+  }
+
+  std::lock_guard<std::mutex> lock(optionTablesMutex);
+  mTable = optionTables.emplace(std::move(key), std::move(table)).first->second;
+}
+
+std::string MatchCallbackBase::getSourceText(SourceLocation start, SourceLocation end,
+                                             const SourceManager& sm,
+                                             const LangOptions& langOpts) const {
+  if (mCountOnly) {
+    return std::string();
+  }
+  return ::getSourceText(start, end, sm, langOpts);
+}
+
+void MatchCallbackBase::LogASTNode(SourceLocation loc, const SourceManager& sm,
+                                   const std::string& expr) {
+  if (!AdmitNode()) {
+    return;
+  }
+  if (mCountOnly) {
+    ++mCounts[sm.getFileID(sm.getExpansionLoc(loc))];
+  } else if (mFindHits) {
+    AddFindHit(loc, sm, expr);
+  } else {
+    ::LogASTNode(loc, sm, expr);
+  }
+}
+
+void MatchCallbackBase::LogReplacement(SourceLocation loc, const SourceManager& sm,
+                                       const std::string& oldExpr, const std::string& newExpr) {
+  if (!AdmitNode()) {
+    return;
+  }
+  if (mCountOnly) {
+    ++mCounts[sm.getFileID(sm.getExpansionLoc(loc))];
+  } else if (mFindHits) {
+    AddFindHit(loc, sm, oldExpr);
+  } else {
+    ::LogReplacement(loc, sm, oldExpr, newExpr);
+  }
+}
+
+bool MatchCallbackBase::AdmitMatch() {
+  if (!mMatchLimit) {
+    return true;
+  }
+  if (!mInMatch) {
+    mInMatch = true;
+    mMatchAdmitted = mMatchLimit->Add();
+  }
+  return mMatchAdmitted;
+}
+
+bool MatchCallbackBase::AdmitNode() {
+  bool admitted = AdmitMatch();
+  EndMatch();
+  if (admitted) {
+    ++mNumNodes;
+  }
+  return admitted;
+}
+
+void MatchCallbackBase::AddFindHit(SourceLocation loc, const SourceManager& sm,
+                                   const std::string& expr) {
+  SourceLocation expansionLoc = sm.getExpansionLoc(loc);
+  if (expansionLoc.isInvalid()) {
+    return;
+  }
+  std::pair<FileID, unsigned> decomposedLoc = sm.getDecomposedLoc(expansionLoc);
+  const FileEntry* fileEntry = sm.getFileEntryForID(decomposedLoc.first);
+  if (!fileEntry) {
+    return;
+  }
+  mFindHits->Add(mId, fileEntry->getName().str(), decomposedLoc.second,
+                 sm.getLineNumber(decomposedLoc.first, decomposedLoc.second),
+                 sm.getColumnNumber(decomposedLoc.first, decomposedLoc.second), expr);
+}
+
+void ParseMatcherOptions(const std::vector<std::string>& ids,
+                         const std::vector<std::string>& args) {
+  ForEachMatcherInstance(ids, args, [](MatchCallbackBase&) { return true; });
+}
+
+void ClearMatcherOptions() {
+  std::lock_guard<std::mutex> lock(optionTablesMutex);
+  optionTables.clear();
+}
+
+bool GetPrefilterTokens(const std::vector<std::string>& ids,
+                        const std::vector<std::string>& args,
+                        std::vector<std::string>& tokens) {
+  auto addTokens = [&tokens](MatchCallbackBase& callback) {
+    auto instanceTokens = callback.GetPrefilterTokens();
+    tokens.insert(tokens.end(), instanceTokens.begin(), instanceTokens.end());
+    return !instanceTokens.empty();
+  };
+  return ForEachMatcherInstance(ids, args, addTokens);
+}
+
 // if there is an existing header with match the regex, insert there,
 // otherwise, following this rule:
 // #include "...."
@@ -40,6 +223,9 @@ llvm::Optional<clang::SourceLocation> MatchCallbackBase::InsertHeader(const clan
                                                                       const clang::FileID& fileID,
                                                                       llvm::StringRef header,
                                                                       llvm::StringRef regex) {
+  if (mCountOnly || !AdmitMatch()) {
+    return llvm::None;
+  }
   const FileEntry* fileEntry = srcMgr.getFileEntryForID(fileID);
   auto fileBuffer = srcMgr.getBufferData(fileID);
   IncludeStyle style;
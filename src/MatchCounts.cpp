@@ -0,0 +1,48 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "MatchCounts.hpp"
+
+#include <iomanip>
+
+void MatchCounts::Add(const std::string& matcher, const std::string& file, uint64_t count) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mTotal += count;
+  mMatchers[matcher] += count;
+  mFiles[file] += count;
+}
+
+void PrintMatchCounts(const MatchCounts& counts, std::ostream& os) {
+  os << '\n' << "Matches: " << counts.total() << '\n';
+
+  os << '\n' << "Matches per matcher:" << "\n\n";
+  for (const auto& pair : counts.matchers()) {
+    os << std::setw(10) << pair.second << "  " << pair.first << '\n';
+  }
+
+  os << '\n' << "Matches per file:" << "\n\n";
+  for (const auto& pair : counts.files()) {
+    os << std::setw(10) << pair.second << "  " << pair.first << '\n';
+  }
+}
@@ -0,0 +1,55 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "MatcherFactory.hpp"
+#include "MatchCallbackBase.hpp"
+#include "CodeXformException.hpp"
+
+#include "llvm/Support/DynamicLibrary.h"
+
+void MatcherFactory::LoadPlugin(const std::string& path) {
+  size_t numMatchers = matcher_map_.size();
+  std::string errMsg;
+  // the static MatcherHelper objects of the library register its matchers
+  // when it is loaded. It stays loaded until the process exits
+  loading_plugin_ = true;
+  duplicate_ids_.clear();
+  auto library = llvm::sys::DynamicLibrary::getPermanentLibrary(path.c_str(), &errMsg);
+  loading_plugin_ = false;
+  if (!library.isValid()) {
+    throw FileSystemException("Cannot load matcher plugin " + path + ": " + errMsg);
+  }
+  if (!duplicate_ids_.empty()) {
+    std::string ids;
+    for (const auto& id : duplicate_ids_) {
+      ids += (ids.empty() ? "" : ", ") + id;
+    }
+    throw CommandLineOptionException("Matcher plugin " + path +
+                                     " registers matchers already registered: " + ids);
+  }
+  if (matcher_map_.size() == numMatchers) {
+    throw CommandLineOptionException("Matcher plugin " + path + " registers no new matcher");
+  }
+  plugins_.push_back(path);
+}
@@ -0,0 +1,208 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "MemoryBudget.hpp"
+#include "CodeXformException.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+
+constexpr const char* kMemoryHistoryHeader = "clang-xform memory v1";
+
+// interval to sample the resident set size while waiting
+constexpr std::chrono::milliseconds kSampleInterval(100);
+
+} // end anonymous namespace
+
+uint64_t GetCurrentRSS() {
+#ifndef _WIN32
+  std::ifstream ifs("/proc/self/statm");
+  uint64_t size = 0, resident = 0;
+  if (ifs >> size >> resident) {
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+  return 0;
+}
+
+void ReleaseFreeMemory() {
+#ifdef __GLIBC__
+  // freed chunks stay in the arenas of the threads unless trimmed
+  malloc_trim(0);
+#endif
+}
+
+bool ParseMemorySize(const std::string& size, uint64_t& bytes) {
+  constexpr uint64_t kMaxSize = std::numeric_limits<uint64_t>::max();
+  size_t pos = 0;
+  uint64_t value = 0;
+  for (; pos < size.size() && std::isdigit(static_cast<unsigned char>(size[pos])); ++pos) {
+    uint64_t digit = size[pos] - '0';
+    // reject sizes overflowing 64 bits
+    if (value > (kMaxSize - digit) / 10) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  if (pos == 0 || pos + 1 < size.size()) {
+    return false;
+  }
+  uint64_t multiplier = 1;
+  if (pos < size.size()) {
+    switch (std::toupper(static_cast<unsigned char>(size[pos]))) {
+      case 'G': multiplier <<= 10;
+        // fall through
+      case 'M': multiplier <<= 10;
+        // fall through
+      case 'K': multiplier <<= 10;
+        break;
+      default:
+        return false;
+    }
+  }
+  if (value > kMaxSize / multiplier) {
+    return false;
+  }
+  bytes = value * multiplier;
+  return true;
+}
+
+MemoryBudget::MemoryBudget(uint64_t budget, uint64_t defaultEstimate)
+    : mBudget(budget),
+      mDefaultEstimate(defaultEstimate),
+      mBaseline(GetCurrentRSS())
+{}
+
+bool MemoryBudget::Load(const std::string& file) {
+  std::ifstream ifs(file);
+  std::string line;
+  if (!std::getline(ifs, line) || line != kMemoryHistoryHeader) {
+    return false;
+  }
+  std::unordered_map<std::string, uint64_t> peaks;
+  while (std::getline(ifs, line)) {
+    std::istringstream iss(line);
+    uint64_t peak = 0;
+    std::string path;
+    if (!(iss >> peak) || !std::getline(iss >> std::ws, path) || path.empty()) {
+      return false;
+    }
+    peaks[path] = peak;
+  }
+  std::lock_guard<std::mutex> guard(mMutex);
+  mPeaks = std::move(peaks);
+  return true;
+}
+
+void MemoryBudget::Save(const std::string& file) const {
+  std::ofstream ofs(file);
+  if (!ofs.good()) {
+    throw FileSystemException("Cannot open file: " + file);
+  }
+  std::lock_guard<std::mutex> guard(mMutex);
+  ofs << kMemoryHistoryHeader << '\n';
+  for (const auto& pair : mPeaks) {
+    ofs << pair.second << ' ' << pair.first << '\n';
+  }
+}
+
+uint64_t MemoryBudget::GetEstimate(const std::string& file) const {
+  std::lock_guard<std::mutex> guard(mMutex);
+  return GetEstimateLocked(file);
+}
+
+uint64_t MemoryBudget::GetEstimateLocked(const std::string& file) const {
+  auto iter = mPeaks.find(file);
+  if (iter != mPeaks.end()) {
+    return iter->second;
+  }
+  // files without history are expected to be as large as the average file
+  if (mPeaks.empty()) {
+    return mDefaultEstimate;
+  }
+  uint64_t total = 0;
+  for (const auto& pair : mPeaks) {
+    total += pair.second;
+  }
+  return total / mPeaks.size();
+}
+
+uint64_t MemoryBudget::GetReserved() const {
+  std::lock_guard<std::mutex> guard(mMutex);
+  return mReserved;
+}
+
+void MemoryBudget::Acquire(const std::string& file) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  uint64_t estimate = GetEstimateLocked(file);
+  // predictions may be lower than the actual usage, so the sampled resident
+  // set size is honored as well
+  auto fits = [this, estimate]() {
+    uint64_t rss = GetCurrentRSS();
+    uint64_t usage = std::max(mBaseline + mReserved, rss);
+    return mInFlight.empty() || usage + estimate <= mBudget;
+  };
+  while (!fits()) {
+    mCondition.wait_for(lock, kSampleInterval);
+  }
+  mReserved += estimate;
+  mInFlight[file].push_back(estimate);
+}
+
+void MemoryBudget::Release(const std::string& file, uint64_t peak) {
+  {
+    std::lock_guard<std::mutex> guard(mMutex);
+    // only release one of the reservations of a file processed several times
+    auto iter = mInFlight.find(file);
+    if (iter != mInFlight.end()) {
+      mReserved -= iter->second.back();
+      iter->second.pop_back();
+      if (iter->second.empty()) {
+        mInFlight.erase(iter);
+      }
+    }
+    if (peak > 0) {
+      mPeaks[file] = peak;
+    }
+  }
+  mCondition.notify_all();
+}
+
+std::string GetMemoryHistoryFile(const std::string& cacheDir) {
+  return cacheDir + "/memory-history.txt";
+}
@@ -0,0 +1,134 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Prefilter.hpp"
+#include "CoreUtil.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <thread>
+
+#include "llvm/Support/MemoryBuffer.h"
+
+using namespace llvm;
+
+namespace {
+
+bool IsIdentifierHead(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool IsIdentifierBody(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+} // end anonymous namespace
+
+bool Prefilter::SetTokens(const std::vector<std::string>& tokens) {
+  mTokens.clear();
+  for (const auto& token : tokens) {
+    if (token.empty() || !IsIdentifierHead(token[0]) ||
+        !std::all_of(token.begin(), token.end(), IsIdentifierBody)) {
+      return false;
+    }
+  }
+  std::vector<std::string> sorted(tokens);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  mTokens = std::move(sorted);
+  return true;
+}
+
+bool Prefilter::Match(StringRef text) const {
+  // look up each identifier of the text, skipping the other characters
+  const char* pos = text.data();
+  const char* end = pos + text.size();
+  while (pos != end) {
+    if (!IsIdentifierHead(*pos)) {
+      ++pos;
+      continue;
+    }
+    const char* begin = pos;
+    while (pos != end && IsIdentifierBody(*pos)) {
+      ++pos;
+    }
+    StringRef identifier(begin, pos - begin);
+    if (std::binary_search(mTokens.begin(), mTokens.end(), identifier,
+                           [](StringRef a, StringRef b) {return a < b;})) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<bool> Prefilter::MatchFiles(const std::vector<std::string>& files,
+                                        unsigned int numThreads) const {
+  std::vector<char> likely(files.size(), 0);
+  std::atomic<size_t> next{0};
+  auto worker = [this, &files, &likely, &next]() {
+    for (size_t i = next++; i < files.size(); i = next++) {
+      auto buffer = MemoryBuffer::getFile(files[i]);
+      if (buffer) {
+        likely[i] = Match((*buffer)->getBuffer());
+      }
+    }
+  };
+  auto numWorkers = std::max(1u, std::min(numThreads, std::thread::hardware_concurrency()));
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < numWorkers; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return std::vector<bool>(likely.begin(), likely.end());
+}
+
+std::vector<std::string> ScheduleLikelyFirst(const std::vector<std::string>& files,
+                                             const std::vector<bool>& likely,
+                                             unsigned int numThreads) {
+  // likely files first, otherwise keep the given order
+  std::vector<size_t> order(files.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_partition(order.begin(), order.end(),
+                        [&likely](size_t i) {return likely[i];});
+
+  // deal the files to the batches in turn, so that every batch starts with
+  // the files likely to match
+  auto batches = PartitionFiles(files.size(), numThreads);
+  std::vector<std::string> scheduled(files.size());
+  size_t next = 0;
+  for (size_t round = 0; next < order.size(); ++round) {
+    for (const auto& batch : batches) {
+      if (batch.first + round < batch.second) {
+        scheduled[batch.first + round] = files[order[next++]];
+      }
+    }
+  }
+  return scheduled;
+}
@@ -0,0 +1,146 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Preflight.hpp"
+#include "IncludeGraph.hpp"
+#include "CoreUtil.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+#include "llvm/Support/FileSystem.h"
+
+using namespace llvm;
+using namespace llvm::sys;
+
+namespace {
+
+// print the given number of bytes in MB
+std::string FormatBytes(uint64_t bytes) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(1) << double(bytes) / (1024 * 1024) << " MB";
+  return oss.str();
+}
+
+} // end anonymous namespace
+
+PreflightReport GetPreflightReport(const IncludeGraph& graph,
+                                   const std::vector<std::string>& files,
+                                   unsigned int numThreads,
+                                   double bytesPerSecond)
+{
+  PreflightReport report;
+  // size and fan-in of each file reached
+  std::unordered_map<std::string, HeaderFanIn> sizes;
+  auto getSize = [&sizes](const std::string& file) -> HeaderFanIn& {
+    auto iter = sizes.find(file);
+    if (iter == sizes.end()) {
+      HeaderFanIn entry;
+      entry.header = file;
+      fs::file_status status;
+      if (!fs::status(file, status)) {
+        entry.bytes = status.getSize();
+      }
+      iter = sizes.emplace(file, std::move(entry)).first;
+    }
+    return iter->second;
+  };
+
+  for (const auto& file : files) {
+    FileCost cost;
+    cost.file = file;
+    cost.bytes = getSize(file).bytes;
+    auto headers = graph.GetIncludedHeaders(file);
+    cost.numHeaders = headers.size();
+    for (const auto& header : headers) {
+      HeaderFanIn& entry = getSize(header);
+      ++entry.numIncluders;
+      cost.bytes += entry.bytes;
+    }
+    cost.seconds = double(cost.bytes) / bytesPerSecond;
+    report.includeVolume += cost.bytes;
+    report.files.push_back(std::move(cost));
+  }
+
+  // each batch is processed sequentially by one thread
+  auto batches = PartitionFiles(files.size(), numThreads);
+  report.numBatches = batches.size();
+  for (const auto& batch : batches) {
+    double seconds = 0;
+    for (size_t i = batch.first; i < batch.second; ++i) {
+      seconds += report.files[i].seconds;
+    }
+    report.wallSeconds = std::max(report.wallSeconds, seconds);
+  }
+
+  for (auto& pair : sizes) {
+    report.uniqueBytes += pair.second.bytes;
+    if (pair.second.numIncluders > 0) {
+      report.headers.push_back(std::move(pair.second));
+    }
+  }
+
+  std::sort(report.files.begin(), report.files.end(),
+            [](const FileCost& lhs, const FileCost& rhs)
+            {return lhs.bytes != rhs.bytes ? lhs.bytes > rhs.bytes : lhs.file < rhs.file;});
+  std::sort(report.headers.begin(), report.headers.end(),
+            [](const HeaderFanIn& lhs, const HeaderFanIn& rhs)
+            {
+              uint64_t lhsVolume = lhs.bytes * lhs.numIncluders;
+              uint64_t rhsVolume = rhs.bytes * rhs.numIncluders;
+              return lhsVolume != rhsVolume ? lhsVolume > rhsVolume : lhs.header < rhs.header;
+            });
+  return report;
+}
+
+void PrintPreflightReport(const PreflightReport& report, std::ostream& os, size_t numEntries) {
+  double totalSeconds = 0;
+  for (const auto& cost : report.files) {
+    totalSeconds += cost.seconds;
+  }
+
+  os << '\n' << "Files: " << report.files.size() << '\n'
+     << "Include volume: " << FormatBytes(report.includeVolume)
+     << " (" << FormatBytes(report.uniqueBytes) << " unique)" << '\n'
+     << std::fixed << std::setprecision(1)
+     << "Estimated parse time: " << totalSeconds << " s" << '\n'
+     << "Predicted wall time: " << report.wallSeconds << " s with "
+     << report.numBatches << " threads" << '\n';
+
+  os << '\n' << "Most expensive files:" << "\n\n";
+  for (size_t i = 0; i < std::min(numEntries, report.files.size()); ++i) {
+    const auto& cost = report.files[i];
+    os << std::setw(10) << FormatBytes(cost.bytes) << std::setw(8) << cost.numHeaders
+       << std::setw(8) << cost.seconds << " s  " << cost.file << '\n';
+  }
+
+  os << '\n' << "Header fan-in hotspots:" << "\n\n";
+  for (size_t i = 0; i < std::min(numEntries, report.headers.size()); ++i) {
+    const auto& entry = report.headers[i];
+    os << std::setw(10) << FormatBytes(entry.bytes * entry.numIncluders)
+       << std::setw(8) << entry.numIncluders << "  " << entry.header << '\n';
+  }
+}
@@ -0,0 +1,183 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "QueryCallback.hpp"
+#include "CodeXformException.hpp"
+#include "MatchCallbackBase.hpp"
+#include "MatcherHelper.hpp"
+#include "ToolingUtil.hpp"
+
+#include <cctype>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include "clang/AST/ASTContext.h"
+#include "clang/ASTMatchers/Dynamic/Diagnostics.h"
+#include "clang/ASTMatchers/Dynamic/Parser.h"
+#include "clang/Basic/SourceManager.h"
+
+using namespace clang;
+using namespace clang::ast_matchers;
+
+namespace {
+
+const std::string optionExpression = "expression";
+const std::string rootID = "root";
+
+// replace runs of white spaces, including new lines, by a single space
+std::string CollapseSpaces(const std::string& text) {
+  std::string result;
+  result.reserve(text.size());
+  bool space = false;
+  for (char c : text) {
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      space = true;
+      continue;
+    }
+    if (space && !result.empty()) {
+      result += ' ';
+    }
+    space = false;
+    result += c;
+  }
+  return result;
+}
+
+// Match callback running the matcher expression of --query. It prints one
+// line per node matched in the main file:
+// file:line:col: source text
+// or records the nodes into the find index with --find-index, or counts them
+// with --count-only
+class QueryCallback : public MatchCallbackBase {
+ public:
+  explicit QueryCallback(const std::string& id,
+                         clang::tooling::Replacements& replacements,
+                         std::vector<std::string> args)
+      : MatchCallbackBase(id, replacements, std::move(args))
+  {}
+
+  void RegisterOptions() override {
+    AddOption<std::string>(optionExpression);
+  }
+
+  void ParseOptions() override {
+    MatchCallbackBase::ParseOptions();
+    if (!HasOption(optionExpression)) {
+      throw CommandLineOptionException("Matcher " + std::string(kQueryMatcherId) +
+                                       " requires --" + optionExpression);
+    }
+    mMatcher = ParseQuery(GetOption<std::string>(optionExpression));
+  }
+
+  // names given to hasName in the expression, if any
+  std::vector<std::string> GetPrefilterTokens() const override {
+    std::vector<std::string> tokens;
+    const std::string& expression = GetOption<std::string>(optionExpression);
+    const std::string prefix = "hasName(\"";
+    for (auto pos = expression.find(prefix); pos != std::string::npos;
+         pos = expression.find(prefix, pos)) {
+      pos += prefix.size();
+      auto end = expression.find('"', pos);
+      if (end == std::string::npos) {
+        break;
+      }
+      std::string name = expression.substr(pos, end - pos);
+      auto scope = name.rfind("::");
+      tokens.push_back(scope == std::string::npos ? name : name.substr(scope + 2));
+    }
+    return tokens;
+  }
+
+  void RegisterMatchers(MatchFinder* finder) override {
+    // function bodies in headers are parsed since the expression may look into
+    // them, e.g. through hasBody(), even though only main file nodes are printed
+    finder->addDynamicMatcher(*mMatcher, this);
+  }
+
+  void run(const MatchFinder::MatchResult& Result) override {
+    const auto& nodes = Result.Nodes.getMap();
+    auto iter = nodes.find(rootID);
+    if (iter == nodes.end()) {
+      return;
+    }
+    const SourceManager& srcMgr = *Result.SourceManager;
+    CharSourceRange range = srcMgr.getExpansionRange(iter->second.getSourceRange());
+    SourceLocation begin = range.getBegin();
+    if (begin.isInvalid() || !srcMgr.isInMainFile(begin)) {
+      return;
+    }
+    SourceLocation end = range.getEnd();
+    std::string text;
+    if (end.isValid() && srcMgr.getFileID(begin) == srcMgr.getFileID(end) &&
+        !srcMgr.isBeforeInTranslationUnit(end, begin)) {
+      text = CollapseSpaces(getSourceText(begin, end, srcMgr, Result.Context->getLangOpts()));
+    }
+    // with --find-index or --count-only, the matches are recorded or counted instead
+    if (IsFindOnly() || IsCountOnly()) {
+      LogASTNode(begin, srcMgr, text);
+      return;
+    }
+    if (!AdmitNode()) {
+      return;
+    }
+    std::ostringstream oss;
+    oss << begin.printToString(srcMgr) << ": " << text << '\n';
+    // lines of concurrent files are not interleaved
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::cout << oss.str();
+  }
+
+ private:
+  std::shared_ptr<const internal::DynTypedMatcher> mMatcher;
+};
+
+MatcherHelper<QueryCallback> RegisterQueryMatcher(kQueryMatcherId);
+
+} // end anonymous namespace
+
+std::shared_ptr<const internal::DynTypedMatcher>
+ParseQuery(const std::string& expression) {
+  static std::mutex mutex;
+  static std::map<std::string, std::shared_ptr<const internal::DynTypedMatcher> > queries;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto iter = queries.find(expression);
+  if (iter != queries.end()) {
+    return iter->second;
+  }
+
+  dynamic::Diagnostics diag;
+  auto matcher = dynamic::Parser::parseMatcherExpression(expression, &diag);
+  if (!matcher) {
+    throw CommandLineOptionException("Invalid query: " + diag.toStringFull());
+  }
+  auto bound = matcher->tryBind(rootID);
+  if (!bound) {
+    throw CommandLineOptionException("Query matcher cannot be bound: " + expression);
+  }
+  auto query = std::make_shared<const internal::DynTypedMatcher>(std::move(*bound));
+  return queries.emplace(expression, std::move(query)).first->second;
+}
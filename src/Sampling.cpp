@@ -0,0 +1,178 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Sampling.hpp"
+#include "CoreUtil.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <utility>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+
+using namespace llvm;
+
+namespace {
+
+// quantile of the normal distribution for a 95% confidence interval
+constexpr double kNormalQuantile95 = 1.96;
+
+// absolute paths without dots, as recorded by CodeXformAction
+std::string NormalizePath(const std::string& file) {
+  SmallString<256> path(file);
+  sys::path::remove_dots(path, true);
+  return path.str().str();
+}
+
+// extrapolate the sum of the given values over numFiles files
+Estimate Extrapolate(const std::vector<double>& values, size_t numFiles) {
+  Estimate estimate;
+  const double n = values.size();
+  const double N = numFiles;
+  if (values.empty()) {
+    return estimate;
+  }
+  double sum = 0;
+  for (auto value : values) {
+    sum += value;
+  }
+  estimate.value = sum * N / n;
+  if (values.size() > 1) {
+    // successive difference variance of a systematic sample
+    double squares = 0;
+    for (size_t i = 1; i < values.size(); ++i) {
+      squares += (values[i] - values[i - 1]) * (values[i] - values[i - 1]);
+    }
+    double variance = squares / (2 * (n - 1));
+    estimate.margin = kNormalQuantile95 * N * std::sqrt((1 - n / N) * variance / n);
+    estimate.hasMargin = true;
+  }
+  return estimate;
+}
+
+Estimate Scale(Estimate estimate, double factor) {
+  estimate.value *= factor;
+  estimate.margin *= factor;
+  return estimate;
+}
+
+void PrintEstimate(const std::string& name, const Estimate& estimate, const std::string& unit,
+                   std::ostream& os) {
+  os << name << estimate.value << unit;
+  if (estimate.hasMargin) {
+    os << " +/- " << estimate.margin << unit;
+  }
+  os << '\n';
+}
+
+} // end anonymous namespace
+
+std::vector<std::string> SampleFiles(std::vector<std::string> files, double fraction,
+                                     uint64_t seed) {
+  if (files.empty()) {
+    return files;
+  }
+  // keep the files of each directory together, subdirectories excluded
+  std::sort(files.begin(), files.end(),
+            [](const std::string& a, const std::string& b) {
+              return std::make_pair(sys::path::parent_path(a), StringRef(a)) <
+                  std::make_pair(sys::path::parent_path(b), StringRef(b));
+            });
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+
+  const size_t numSampled = std::min(
+      files.size(), std::max(size_t(1), static_cast<size_t>(std::llround(fraction * files.size()))));
+  const double step = double(files.size()) / numSampled;
+  std::mt19937_64 engine(seed);
+  double position = std::uniform_real_distribution<double>(0, step)(engine);
+
+  std::vector<std::string> sample;
+  sample.reserve(numSampled);
+  for (size_t i = 0; i < numSampled; ++i, position += step) {
+    sample.push_back(files[std::min(files.size() - 1, static_cast<size_t>(position))]);
+  }
+  return sample;
+}
+
+void SampleStats::Add(const std::string& file, const FileStats& stats) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  FileStats& total = mFiles[NormalizePath(file)];
+  total.matches += stats.matches;
+  total.replacements += stats.replacements;
+  total.replacementBytes += stats.replacementBytes;
+  total.seconds += stats.seconds;
+}
+
+FileStats SampleStats::Get(const std::string& file) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto iter = mFiles.find(NormalizePath(file));
+  return iter == mFiles.end() ? FileStats() : iter->second;
+}
+
+SampleEstimate EstimateTotals(const SampleStats& stats,
+                              const std::vector<std::string>& sampledFiles,
+                              size_t numFiles,
+                              unsigned int numThreads) {
+  SampleEstimate estimate;
+  estimate.numFiles = numFiles;
+  estimate.numSampled = sampledFiles.size();
+
+  std::vector<double> matches;
+  std::vector<double> replacements;
+  std::vector<double> replacementBytes;
+  std::vector<double> seconds;
+  for (const auto& file : sampledFiles) {
+    FileStats fileStats = stats.Get(file);
+    matches.push_back(fileStats.matches);
+    replacements.push_back(fileStats.replacements);
+    replacementBytes.push_back(fileStats.replacementBytes);
+    seconds.push_back(fileStats.seconds);
+  }
+  estimate.matches = Extrapolate(matches, numFiles);
+  estimate.replacements = Extrapolate(replacements, numFiles);
+  estimate.replacementBytes = Extrapolate(replacementBytes, numFiles);
+  estimate.fileSeconds = Extrapolate(seconds, numFiles);
+  // the batches of ProcessFiles have about the same number of files
+  estimate.numBatches = PartitionFiles(numFiles, numThreads).size();
+  if (estimate.numBatches) {
+    estimate.wallSeconds = Scale(estimate.fileSeconds, 1.0 / estimate.numBatches);
+  }
+  return estimate;
+}
+
+void PrintSampleEstimate(const SampleEstimate& estimate, std::ostream& os) {
+  os << '\n' << "Sampled files: " << estimate.numSampled << " of " << estimate.numFiles << '\n'
+     << "Estimated totals with 95% confidence intervals:" << "\n\n"
+     << std::fixed << std::setprecision(0);
+  PrintEstimate("Matches: ", estimate.matches, "", os);
+  PrintEstimate("Replacements: ", estimate.replacements, "", os);
+  PrintEstimate("Replacement volume: ", estimate.replacementBytes, " bytes", os);
+  os << std::setprecision(1);
+  PrintEstimate("Parse and match time: ", estimate.fileSeconds, " s", os);
+  PrintEstimate("Predicted wall time with " + std::to_string(estimate.numBatches) + " threads: ",
+                estimate.wallSeconds, " s", os);
+}
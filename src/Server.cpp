@@ -0,0 +1,395 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Server.hpp"
+#include "CoreUtil.hpp"
+#include "CodeXformException.hpp"
+#include "MatcherFactory.hpp"
+#include "MatchCallbackBase.hpp"
+#include "SharedFileCache.hpp"
+#include "cxxlog.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace cxxlog;
+using namespace clang::tooling;
+using namespace llvm;
+using namespace llvm::sys;
+
+namespace {
+
+const std::string kRequestHeader = "clang-xform request v1";
+const std::string kResponseHeader = "clang-xform response v1";
+// a request is sent at once by the client, so a client that does not finish
+// sending its request within this time would only block the next ones
+const int kRequestTimeoutSeconds = 30;
+
+void AppendList(std::vector<std::string>& fields, const std::vector<std::string>& list) {
+  fields.push_back(std::to_string(list.size()));
+  fields.insert(fields.end(), list.begin(), list.end());
+}
+
+// read a list starting at fields[pos] and advance pos
+bool ReadList(const std::vector<std::string>& fields, size_t& pos, std::vector<std::string>& list) {
+  size_t size;
+  if (pos >= fields.size() || StringRef(fields[pos]).getAsInteger(10, size) ||
+      size > fields.size() - pos - 1) {
+    return false;
+  }
+  list.assign(fields.begin() + pos + 1, fields.begin() + pos + 1 + size);
+  pos += size + 1;
+  return true;
+}
+
+#ifndef _WIN32
+
+volatile sig_atomic_t sInterrupted = 0;
+
+void HandleSignal(int) {
+  sInterrupted = 1;
+}
+
+sockaddr_un GetSocketAddress(const std::string& socketFile) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socketFile.size() >= sizeof(address.sun_path)) {
+    throw ServerException("Socket path is too long: " + socketFile);
+  }
+  std::strcpy(address.sun_path, socketFile.c_str());
+  return address;
+}
+
+bool WriteAll(int fd, StringRef data) {
+  while (!data.empty()) {
+    ssize_t size = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (size < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data = data.drop_front(size);
+  }
+  return true;
+}
+
+// read until the peer shuts down its end
+bool ReadAll(int fd, std::string& data) {
+  char buffer[65536];
+  while (true) {
+    ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+    if (size < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    if (size == 0) {
+      return true;
+    }
+    data.append(buffer, size);
+  }
+}
+
+ServerResponse HandleRequest(const ServerRequest& request,
+                             const CompilationDatabase& compilationDatabase,
+                             const std::vector<std::string>& allFiles,
+                             unsigned int numThreads,
+                             IntrusiveRefCntPtr<SharedFileCache> fileCache)
+{
+  ServerResponse response;
+  MatcherFactory& factory = MatcherFactory::Instance();
+  for (const auto& matcher : request.matchers) {
+    if (factory.getMatcherMap().find(matcher) == factory.getMatcherMap().end()) {
+      response.status = 1;
+      response.error = "Matcher ID: " + matcher + " is not registered!";
+      return response;
+    }
+  }
+  try {
+    ParseMatcherOptions(request.matchers, request.matcherArgs);
+  } catch (CommandLineOptionException& e) {
+    response.status = 1;
+    response.error = e.what();
+    return response;
+  } catch (std::exception& e) {
+    // includes cxxopts::OptionException
+    response.status = 1;
+    response.error = e.what();
+    return response;
+  }
+
+  SmallString<256> outputFile;
+  int fd;
+  if (fs::createTemporaryFile("clang-xform", "yaml", fd, outputFile)) {
+    response.status = 1;
+    response.error = "Cannot create temporary file";
+    return response;
+  }
+  close(fd);
+
+  SmallString<256> cwd;
+  fs::current_path(cwd);
+  // files modified since the last request are read again
+  fileCache->NewGeneration();
+  try {
+    response.status = ProcessFiles(compilationDatabase,
+                                   request.inputFiles.empty() ? allFiles : request.inputFiles,
+                                   outputFile.str().str(),
+                                   request.matchers, request.matcherArgs,
+                                   std::min(numThreads, request.numThreads),
+                                   request.options, fileCache);
+  }
+  catch (std::exception& e) {
+    // a failed request must neither stop the server nor leak the temporary file
+    response.status = 1;
+    response.error = e.what();
+  }
+  fs::set_current_path(cwd);
+
+  auto buffer = MemoryBuffer::getFile(outputFile);
+  if (buffer) {
+    response.replacements = buffer.get()->getBuffer().str();
+  }
+  fs::remove(outputFile);
+  return response;
+}
+
+#endif
+
+} // end anonymous namespace
+
+std::string EncodeMessage(const std::vector<std::string>& fields) {
+  std::string message;
+  for (const auto& field : fields) {
+    message += std::to_string(field.size());
+    message += ':';
+    message += field;
+  }
+  return message;
+}
+
+bool DecodeMessage(StringRef message, std::vector<std::string>& fields) {
+  fields.clear();
+  while (!message.empty()) {
+    auto pos = message.find(':');
+    size_t size;
+    if (pos == StringRef::npos || message.substr(0, pos).getAsInteger(10, size) ||
+        size > message.size() - pos - 1) {
+      return false;
+    }
+    fields.push_back(message.substr(pos + 1, size).str());
+    message = message.drop_front(pos + 1 + size);
+  }
+  return true;
+}
+
+std::string EncodeRequest(const ServerRequest& request) {
+  std::vector<std::string> fields = {kRequestHeader, std::to_string(request.numThreads)};
+  AppendList(fields, request.inputFiles);
+  AppendList(fields, request.matchers);
+  AppendList(fields, request.matcherArgs);
+  AppendList(fields, EncodeOptions(request.options));
+  return EncodeMessage(fields);
+}
+
+bool DecodeRequest(StringRef message, ServerRequest& request) {
+  std::vector<std::string> fields;
+  if (!DecodeMessage(message, fields) || fields.size() < 2 || fields[0] != kRequestHeader ||
+      StringRef(fields[1]).getAsInteger(10, request.numThreads)) {
+    return false;
+  }
+  size_t pos = 2;
+  std::vector<std::string> options;
+  return ReadList(fields, pos, request.inputFiles) &&
+      ReadList(fields, pos, request.matchers) &&
+      ReadList(fields, pos, request.matcherArgs) &&
+      ReadList(fields, pos, options) &&
+      pos == fields.size() &&
+      DecodeOptions(options, request.options);
+}
+
+std::string EncodeResponse(const ServerResponse& response) {
+  return EncodeMessage({kResponseHeader, std::to_string(response.status),
+                        response.error, response.replacements});
+}
+
+bool DecodeResponse(StringRef message, ServerResponse& response) {
+  std::vector<std::string> fields;
+  if (!DecodeMessage(message, fields) || fields.size() != 4 || fields[0] != kResponseHeader ||
+      StringRef(fields[1]).getAsInteger(10, response.status)) {
+    return false;
+  }
+  response.error = std::move(fields[2]);
+  response.replacements = std::move(fields[3]);
+  return true;
+}
+
+#ifndef _WIN32
+
+void RunServer(const std::string& socketFile,
+               const CompilationDatabase& compilationDatabase,
+               unsigned int numThreads)
+{
+  sockaddr_un address = GetSocketAddress(socketFile);
+  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server < 0) {
+    throw ServerException("Cannot create socket: " + std::string(std::strerror(errno)));
+  }
+  // remove the socket left by a previous server
+  unlink(socketFile.c_str());
+  if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+      listen(server, SOMAXCONN) < 0) {
+    std::string error = std::strerror(errno);
+    close(server);
+    throw ServerException("Cannot listen on socket " + socketFile + ": " + error);
+  }
+
+  // stop on SIGINT and SIGTERM. accept is interrupted since SA_RESTART is not set
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = HandleSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  const std::vector<std::string> allFiles = compilationDatabase.getAllFiles();
+  IntrusiveRefCntPtr<SharedFileCache> fileCache(new SharedFileCache());
+
+  TRIVIAL_LOG(info) << "Listening on " << socketFile << '\n';
+  while (!sInterrupted) {
+    int client = accept(server, nullptr, nullptr);
+    if (client < 0) {
+      continue;
+    }
+    timeval timeout;
+    timeout.tv_sec = kRequestTimeoutSeconds;
+    timeout.tv_usec = 0;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    std::string message;
+    ServerRequest request;
+    ServerResponse response;
+    if (!ReadAll(client, message)) {
+      response.status = 1;
+      response.error = (errno == EAGAIN || errno == EWOULDBLOCK) ?
+          "Request timed out after " + std::to_string(kRequestTimeoutSeconds) + " seconds" :
+          "Cannot read request: " + std::string(std::strerror(errno));
+    } else if (!DecodeRequest(message, request)) {
+      response.status = 1;
+      response.error = "Invalid request";
+    } else {
+      TRIVIAL_LOG(info) << "Processing request: " << request.inputFiles.size() << " files" << '\n';
+      try {
+        response = HandleRequest(request, compilationDatabase, allFiles, numThreads, fileCache);
+      } catch (std::exception& e) {
+        response = ServerResponse();
+        response.status = 1;
+        response.error = e.what();
+      }
+      // the arguments of each request differ, do not keep their option tables
+      ClearMatcherOptions();
+      TRIVIAL_LOG(info) << "Cached files: " << fileCache->GetNumCachedFiles() << '\n';
+    }
+    if (!WriteAll(client, EncodeResponse(response))) {
+      TRIVIAL_LOG(warning) << "Cannot send response: " << std::strerror(errno) << '\n';
+    }
+    close(client);
+  }
+
+  close(server);
+  unlink(socketFile.c_str());
+}
+
+int ProcessFilesRemotely(const std::string& socketFile,
+                         const std::vector<std::string>& inputFiles,
+                         const std::string& outputFile,
+                         const std::vector<std::string>& matchers,
+                         const std::vector<std::string>& matcherArgs,
+                         unsigned int numThreads,
+                         const CodeXformOptions& options)
+{
+  sockaddr_un address = GetSocketAddress(socketFile);
+  int server = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (server < 0 ||
+      connect(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+    std::string error = std::strerror(errno);
+    if (server >= 0) close(server);
+    throw ServerException("Cannot connect to server " + socketFile + ": " + error);
+  }
+
+  ServerRequest request;
+  request.inputFiles = inputFiles;
+  request.matchers = matchers;
+  request.matcherArgs = matcherArgs;
+  request.numThreads = numThreads;
+  request.options = options;
+  std::string message;
+  bool received = WriteAll(server, EncodeRequest(request)) &&
+      shutdown(server, SHUT_WR) == 0 &&
+      ReadAll(server, message);
+  close(server);
+
+  ServerResponse response;
+  if (!received || !DecodeResponse(message, response)) {
+    throw ServerException("Invalid response from server " + socketFile);
+  }
+  if (response.status != 0 && !response.error.empty()) {
+    throw RunClangToolException(response.error);
+  }
+
+  std::error_code EC;
+  raw_fd_ostream OS(outputFile, EC, fs::F_Append);
+  if (EC) {
+    throw FileSystemException("Cannot open file: " + outputFile);
+  }
+  OS << response.replacements;
+  return response.status;
+}
+
+#else
+
+void RunServer(const std::string&, const CompilationDatabase&, unsigned int) {
+  throw ServerException("Server mode is not supported on Windows");
+}
+
+int ProcessFilesRemotely(const std::string&, const std::vector<std::string>&,
+                         const std::string&, const std::vector<std::string>&,
+                         const std::vector<std::string>&, unsigned int,
+                         const CodeXformOptions&) {
+  throw ServerException("Server mode is not supported on Windows");
+}
+
+#endif
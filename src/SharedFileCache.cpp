@@ -0,0 +1,174 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "SharedFileCache.hpp"
+
+#include "llvm/ADT/SmallString.h"
+
+using namespace llvm;
+
+namespace {
+
+// a memory buffer sharing the content cached by SharedFileCache
+class SharedMemoryBuffer : public MemoryBuffer {
+ public:
+  SharedMemoryBuffer(std::shared_ptr<MemoryBuffer> content, const std::string& name)
+      : mContent(std::move(content)), mName(name)
+  {
+    init(mContent->getBufferStart(), mContent->getBufferEnd(), false);
+  }
+
+  StringRef getBufferIdentifier() const override { return mName; }
+
+  BufferKind getBufferKind() const override { return mContent->getBufferKind(); }
+
+ private:
+  std::shared_ptr<MemoryBuffer> mContent;
+  std::string mName;
+};
+
+class CachedFile : public vfs::File {
+ public:
+  CachedFile(const vfs::Status& status, std::shared_ptr<MemoryBuffer> content)
+      : mStatus(status), mContent(std::move(content))
+  {}
+
+  ErrorOr<vfs::Status> status() override { return mStatus; }
+
+  ErrorOr<std::unique_ptr<MemoryBuffer> >
+  getBuffer(const Twine& name, int64_t, bool, bool) override {
+    return std::unique_ptr<MemoryBuffer>(new SharedMemoryBuffer(mContent, name.str()));
+  }
+
+  std::error_code close() override { return std::error_code(); }
+
+ private:
+  vfs::Status mStatus;
+  std::shared_ptr<MemoryBuffer> mContent;
+};
+
+bool IsSameFile(const vfs::Status& lhs, const vfs::Status& rhs) {
+  return lhs.getUniqueID() == rhs.getUniqueID() &&
+      lhs.getSize() == rhs.getSize() &&
+      lhs.getLastModificationTime() == rhs.getLastModificationTime();
+}
+
+} // end anonymous namespace
+
+SharedFileCache::SharedFileCache(IntrusiveRefCntPtr<vfs::FileSystem> FS)
+    : ProxyFileSystem(std::move(FS))
+{}
+
+void SharedFileCache::NewGeneration() {
+  std::lock_guard<std::mutex> guard(mMutex);
+  ++mGeneration;
+}
+
+size_t SharedFileCache::GetNumCachedFiles() const {
+  std::lock_guard<std::mutex> guard(mMutex);
+  return mContents.size();
+}
+
+ErrorOr<vfs::Status> SharedFileCache::status(const Twine& path) {
+  std::string key = GetKey(path);
+  unsigned generation;
+  {
+    std::lock_guard<std::mutex> guard(mMutex);
+    auto iter = mEntries.find(key);
+    if (iter != mEntries.end() && iter->second.generation == mGeneration) {
+      if (iter->second.error) {
+        return iter->second.error;
+      }
+      return vfs::Status::copyWithNewName(iter->second.status, path.str());
+    }
+    generation = mGeneration;
+  }
+
+  // stat without holding the lock
+  auto result = ProxyFileSystem::status(path);
+
+  std::lock_guard<std::mutex> guard(mMutex);
+  Entry& entry = mEntries[key];
+  if (!entry.error && (!result || entry.status.getUniqueID() != result->getUniqueID())) {
+    // the path refers to another file now, release the content of the old one
+    mContents.erase(entry.status.getUniqueID());
+  }
+  entry.generation = generation;
+  entry.error = result.getError();
+  if (result) {
+    entry.status = *result;
+  }
+  return result;
+}
+
+ErrorOr<std::unique_ptr<vfs::File> >
+SharedFileCache::openFileForRead(const Twine& path) {
+  auto result = status(path);
+  if (!result) {
+    return result.getError();
+  }
+
+  std::shared_ptr<MemoryBuffer> content;
+  {
+    std::lock_guard<std::mutex> guard(mMutex);
+    auto iter = mContents.find(result->getUniqueID());
+    if (iter != mContents.end() && IsSameFile(iter->second.status, *result)) {
+      content = iter->second.buffer;
+    }
+  }
+
+  if (!content) {
+    auto file = ProxyFileSystem::openFileForRead(path);
+    if (!file) {
+      return file.getError();
+    }
+    // the content is copied into memory rather than memory mapped, since a
+    // mapped file modified on disk would change the cached content under the
+    // readers and keep the file mapped as long as it is cached
+    auto buffer = (*file)->getBuffer(path, result->getSize(), true, /*IsVolatile=*/true);
+    if (!buffer) {
+      return buffer.getError();
+    }
+    content = std::move(*buffer);
+
+    // only cache the content matching the status, otherwise the file is
+    // being modified and will be read again in the next generation
+    if (content->getBufferSize() == result->getSize()) {
+      std::lock_guard<std::mutex> guard(mMutex);
+      Content& cached = mContents[result->getUniqueID()];
+      cached.status = *result;
+      cached.buffer = content;
+    }
+  }
+
+  return std::unique_ptr<vfs::File>(
+      new CachedFile(vfs::Status::copyWithNewName(*result, path.str()), std::move(content)));
+}
+
+std::string SharedFileCache::GetKey(const Twine& path) {
+  SmallString<256> key;
+  path.toVector(key);
+  makeAbsolute(key);
+  return key.str().str();
+}
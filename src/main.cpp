@@ -27,9 +27,22 @@
 #include "CommandLineArgsUtil.hpp"
 #include "cxxlog.hpp"
 #include "CoreUtil.hpp"
+#include "CodeXformOptions.hpp"
 #include "MatcherFactory.hpp"
 #include "MatchCallbackBase.hpp"
 #include "ApplyReplacements.hpp"
+#include "HeaderCompDB.hpp"
+#include "IncludeGraph.hpp"
+#include "IncrementalCache.hpp"
+#include "Server.hpp"
+#include "FileWatcher.hpp"
+#include "Preflight.hpp"
+#include "MemoryBudget.hpp"
+#include "FindIndex.hpp"
+#include "MatchCounts.hpp"
+#include "Sampling.hpp"
+#include "MatchLimit.hpp"
+#include "Prefilter.hpp"
 #include "cxxopts.hpp"
 #include "CodeXformException.hpp"
 
@@ -38,6 +51,11 @@
 #include <sstream>
 #include <iterator>
 #include <cassert>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <thread>
+#include <random>
 
 #include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/JSONCompilationDatabase.h"
@@ -75,6 +93,16 @@ int main(int argc, char **argv) {
     exit(1);
   }
 
+  // load matcher plugins before the matchers are validated
+  try {
+    for (const auto& plugin : args.loadMatchers) {
+      MatcherFactory::Instance().LoadPlugin(plugin);
+    }
+  } catch (CodeXformException& e) {
+    std::cerr << e.what() << '\n';
+    exit(1);
+  }
+
   // validate flags
   if (!ValidateCommandLineArgs(args, matcherArgs, compilations != nullptr, errMsg)) {
     std::cerr << errMsg << '\n';
@@ -94,6 +122,26 @@ int main(int argc, char **argv) {
   bool display = args.display;
   bool quiet = args.quiet;
   bool version = args.version;
+  bool genHeaderCompDB = args.genHeaderCompDB;
+  std::string cacheDir = std::move(args.cacheDir);
+  std::string listIncluders = std::move(args.listIncluders);
+  std::string listIncludes = std::move(args.listIncludes);
+  bool queryIncludeGraph = !listIncluders.empty() || !listIncludes.empty();
+  bool incremental = args.incremental;
+  std::string serverSocket = std::move(args.server);
+  std::string connectSocket = std::move(args.connect);
+  bool watch = args.watch;
+  bool headerOwnership = args.headerOwnership;
+  bool preflight = args.preflight;
+  std::string memoryBudget = std::move(args.memoryBudget);
+  std::string findIndex = std::move(args.findIndex);
+  std::string indexCounts = std::move(args.indexCounts);
+  bool countOnly = args.countOnly;
+  double sample = args.sample;
+  int maxMatches = args.maxMatches;
+  CodeXformOptions options;
+  options.mainFileScope = args.mainFileScope;
+  options.scopeHeaders = std::move(args.scopeHeaders);
 
   // setup log file
   if (logFile.empty()) {
@@ -107,7 +155,9 @@ int main(int argc, char **argv) {
   // is --output is not set, by default the replacements will be applied at the end of the program.
   SmallString<256> tmp_path;
   std::string outputFileName = "tmp_output_file.yaml";
-  if (outputFile.empty() && replaceFile.empty()) {
+  if (outputFile.empty() && replaceFile.empty() && !genHeaderCompDB && !queryIncludeGraph &&
+      serverSocket.empty() && !preflight && findIndex.empty() && indexCounts.empty() &&
+      !countOnly && sample == 0 && maxMatches == 0) {
     outputFile = outputFileName;
   }
 
@@ -139,10 +189,71 @@ int main(int argc, char **argv) {
     fs::make_absolute(tmp_path);
     logFile = tmp_path.str().str();
   }
-  for(auto& file : inputFiles) {
-    tmp_path = file;
+  // by default, cache files are stored next to the compilation database
+  if (cacheDir.empty()) {
+    if (!compileCommands.empty()) {
+      cacheDir = path::parent_path(compileCommands).str();
+    } else {
+      fs::current_path(tmp_path);
+      cacheDir = tmp_path.str();
+    }
+    cacheDir += "/.clang-xform";
+  }
+  tmp_path = cacheDir;
+  fs::make_absolute(tmp_path);
+  cacheDir = tmp_path.str().str();
+  // with --memory-budget, files are only processed while they fit into the budget
+  if (!memoryBudget.empty()) {
+    uint64_t budget = 0;
+    ParseMemorySize(memoryBudget, budget);
+    // without history, each thread gets an equal share of the budget
+    auto numWorkers = std::max(1u, std::min(numThreads, std::thread::hardware_concurrency()));
+    options.memoryBudget = std::make_shared<MemoryBudget>(budget, budget / numWorkers);
+    options.memoryBudget->Load(GetMemoryHistoryFile(cacheDir));
+  }
+  // with --find-index, the nodes found are recorded instead of the replacements
+  if (!findIndex.empty()) {
+    tmp_path = findIndex;
     fs::make_absolute(tmp_path);
-    file = tmp_path.str().str();
+    findIndex = tmp_path.str().str();
+    try {
+      options.findIndex = std::make_shared<FindIndex>(findIndex);
+    }
+    catch (FileSystemException& e) {
+      std::cerr << e.what() << '\n';
+      exit(1);
+    }
+  }
+  // with --max-matches, the run stops once enough nodes are found
+  if (maxMatches > 0) {
+    options.matchLimit = std::make_shared<MatchLimit>(maxMatches);
+  }
+  // with --count-only, the nodes found are only counted
+  if (countOnly) {
+    options.matchCounts = std::make_shared<MatchCounts>();
+  }
+  if (!serverSocket.empty()) {
+    tmp_path = serverSocket;
+    fs::make_absolute(tmp_path);
+    serverSocket = tmp_path.str().str();
+  }
+  if (!connectSocket.empty()) {
+    tmp_path = connectSocket;
+    fs::make_absolute(tmp_path);
+    connectSocket = tmp_path.str().str();
+  }
+  if (!listIncluders.empty()) {
+    listIncluders = GetNormalizedPath(listIncluders);
+  }
+  if (!listIncludes.empty()) {
+    listIncludes = GetNormalizedPath(listIncludes);
+  }
+  for (auto& header : options.scopeHeaders) {
+    header = GetNormalizedPath(header);
+  }
+  // input files are normalized as the paths of the include graph
+  for(auto& file : inputFiles) {
+    file = GetNormalizedPath(file);
   }
 
   // print out version number
@@ -164,6 +275,17 @@ int main(int argc, char **argv) {
     }
     return 0;
   }
+  // when --index-counts is given
+  if (!indexCounts.empty()) {
+    try {
+      PrintFindIndexCounts(CountFindIndex(indexCounts), std::cout);
+    }
+    catch (FileSystemException& e) {
+      std::cerr << e.what() << '\n';
+      exit(1);
+    }
+    return 0;
+  }
   // when -a is given
   if (!replaceFile.empty()) {
     // apply replacements
@@ -183,15 +305,63 @@ int main(int argc, char **argv) {
   }
 
 
+  // with --incremental, only the files affected by changes are processed
+  auto processFiles = [&](const CompilationDatabase& compilationDatabase) {
+    // with --sample, only a subset of the files is processed to estimate a full run
+    if (sample != 0) {
+      std::vector<std::string> sampledFiles = SampleFiles(inputFiles, sample, std::random_device()());
+      options.sampleStats = std::make_shared<SampleStats>();
+      int ret = ProcessFiles(compilationDatabase, sampledFiles, outputFile, matchers, matcherArgs,
+                             numThreads, options);
+      PrintSampleEstimate(EstimateTotals(*options.sampleStats, sampledFiles, inputFiles.size(),
+                                         numThreads), std::cout);
+      return ret;
+    }
+    // with --max-matches, the files likely to match are processed first
+    if (options.matchLimit) {
+      std::vector<std::string> tokens;
+      Prefilter prefilter;
+      if (GetPrefilterTokens(matchers, matcherArgs, tokens) && prefilter.SetTokens(tokens)) {
+        inputFiles = ScheduleLikelyFirst(inputFiles, prefilter.MatchFiles(inputFiles, numThreads),
+                                         numThreads);
+      }
+    }
+    int ret = incremental ?
+        ProcessFilesIncrementally(compilationDatabase, inputFiles, outputFile,
+                                  matchers, matcherArgs, numThreads, cacheDir, options) :
+        ProcessFiles(compilationDatabase, inputFiles, outputFile, matchers, matcherArgs,
+                     numThreads, options);
+    // the memory used by each file predicts the next runs
+    if (options.memoryBudget) {
+      fs::create_directories(cacheDir);
+      options.memoryBudget->Save(GetMemoryHistoryFile(cacheDir));
+    }
+    return ret;
+  };
+
   // store cwd
   std::string cwd;
   fs::current_path(tmp_path);
   cwd = tmp_path.str();
 
   int status = 0;
+  // when --connect is given, the server processes the files
+  if (!connectSocket.empty())
+  {
+    try {
+      // the server resolves relative paths against its own directory
+      status = ProcessFilesRemotely(connectSocket, inputFiles, outputFile, matchers,
+                                    MakePathArgsAbsolute(matcherArgs, {"--mapping-file"}),
+                                    numThreads, options);
+    }
+    catch(CodeXformException& e) {
+      std::cerr << e.what() << '\n';
+      exit(1);
+    }
+  }
   // components option is not specified
   // if -p is given
-  if (!compileCommands.empty())
+  else if (!compileCommands.empty())
   {
     TRIVIAL_LOG(info) << "Loading file: " << compileCommands << '\n';
     auto pos = compileCommands.find_last_of('/');
@@ -208,17 +378,112 @@ int main(int argc, char **argv) {
                 << "Json file does not exist.\n";
       return 1;
     }
+    // when --gen-header-compdb is given
+    if (genHeaderCompDB) {
+      TRIVIAL_LOG(info) << "Generating header compile commands: " << compileCommands << '\n';
+      try {
+        auto count = GenerateHeaderCompDB(compileCommands, *compilations, numThreads);
+        std::cout << '\n' << count << " header compile commands are added into "
+                  << compileCommands << "\n\n";
+      }
+      catch (FileSystemException& e) {
+        std::cerr << e.what() << '\n';
+        exit(1);
+      }
+      fs::set_current_path(cwd);
+      return 0;
+    }
+    // when --list-includers or --list-includes is given
+    if (queryIncludeGraph) {
+      IncludeGraph graph;
+      try {
+        graph = LoadIncludeGraph(cacheDir, *compilations, compilations->getAllFiles(), numThreads);
+      }
+      catch (FileSystemException& e) {
+        std::cerr << e.what() << '\n';
+        exit(1);
+      }
+      if (!listIncluders.empty()) {
+        std::cout << '\n' << "Files including " << listIncluders << ":\n\n";
+        for (const auto& file : graph.GetIncludingFiles(listIncluders)) {
+          std::cout << file << '\n';
+        }
+      }
+      if (!listIncludes.empty()) {
+        std::cout << '\n' << "Headers included by " << listIncludes << ":\n\n";
+        for (const auto& file : graph.GetIncludedHeaders(listIncludes)) {
+          std::cout << file << '\n';
+        }
+      }
+      fs::set_current_path(cwd);
+      return 0;
+    }
+    // when --preflight is given
+    if (preflight) {
+      try {
+        auto files = compilations->getAllFiles();
+        IncludeGraph graph = LoadIncludeGraph(cacheDir, *compilations, files, numThreads);
+        PrintPreflightReport(GetPreflightReport(graph, files, numThreads), std::cout);
+      }
+      catch (FileSystemException& e) {
+        std::cerr << e.what() << '\n';
+        exit(1);
+      }
+      fs::set_current_path(cwd);
+      return 0;
+    }
+    // when --server is given
+    if (!serverSocket.empty()) {
+      try {
+        RunServer(serverSocket, *compilations, numThreads);
+      }
+      catch (ServerException& e) {
+        std::cerr << e.what() << '\n';
+        exit(1);
+      }
+      fs::set_current_path(cwd);
+      return 0;
+    }
     if (inputFiles.empty())
     {
       inputFiles = compilations->getAllFiles();
     }
+    // when --header-ownership is given, each header is assigned to one of the input files
+    if (headerOwnership) {
+      try {
+        IncludeGraph graph = LoadIncludeGraph(cacheDir, *compilations, inputFiles, numThreads);
+        options.headerOwners = std::make_shared<const std::unordered_map<std::string, std::string> >(
+            GetHeaderOwners(graph, inputFiles));
+      }
+      catch (FileSystemException& e) {
+        std::cerr << e.what() << '\n';
+        exit(1);
+      }
+    }
+    // when --watch is given
+    if (watch) {
+      try {
+        WatchFiles(*compilations, inputFiles, outputFile, matchers, matcherArgs, numThreads,
+                   cacheDir, options);
+      }
+      catch (CodeXformException& e) {
+        std::cerr << e.what() << '\n';
+        exit(1);
+      }
+      fs::set_current_path(cwd);
+      return 0;
+    }
     try {
-      status = ProcessFiles(*compilations, inputFiles, outputFile, matchers, matcherArgs, numThreads);
+      status = processFiles(*compilations);
     }
     catch(RunClangToolException& e) {
       std::cerr << e.what() << '\n';
       exit(1);
     }
+    catch(FileSystemException& e) {
+      std::cerr << e.what() << '\n';
+      exit(1);
+    }
   }
   else
   {
@@ -226,12 +491,16 @@ int main(int argc, char **argv) {
       if (compilations) {
         // use fixedCompilationDatabase provided in command line
         try {
-          status = ProcessFiles(*compilations, inputFiles, outputFile, matchers, matcherArgs, numThreads);
+          status = processFiles(*compilations);
         }
         catch(RunClangToolException& e) {
           std::cerr << e.what() << '\n';
           exit(1);
         }
+        catch(FileSystemException& e) {
+          std::cerr << e.what() << '\n';
+          exit(1);
+        }
       }
       else {
         // auto detect compile_commands.json file if only on input file
@@ -243,12 +512,16 @@ int main(int argc, char **argv) {
           return 1;
         }
         try {
-          status = ProcessFiles(*compilations, inputFiles, outputFile, matchers, matcherArgs, numThreads);
+          status = processFiles(*compilations);
         }
         catch(RunClangToolException& e) {
           std::cerr << e.what() << '\n';
           exit(1);
         }
+        catch(FileSystemException& e) {
+          std::cerr << e.what() << '\n';
+          exit(1);
+        }
       }
     }
     else {
@@ -260,8 +533,18 @@ int main(int argc, char **argv) {
   // restore cwd
   fs::set_current_path(cwd);
 
+  if (options.matchLimit && options.matchLimit->Reached()) {
+    std::cout << '\n' << "Stopped after " << options.matchLimit->count() << " matches" << '\n';
+  }
+
   // apply replacement automatically if the outputFile is default
-  if (outputFile.rfind(outputFileName) != std::string::npos) {
+  if (options.matchCounts) {
+    PrintMatchCounts(*options.matchCounts, std::cout);
+  } else if (options.findIndex) {
+    std::cout << '\n' << options.findIndex->size() << " hits are stored in " << findIndex << "\n\n";
+    std::cout << "To count hits per matcher and directory, run:" << "\n\n";
+    std::cout << "clang-xform --index-counts " + findIndex << '\n';
+  } else if (outputFile.rfind(outputFileName) != std::string::npos) {
     // apply replacements
     TRIVIAL_LOG(info) << "Apply replacements: " << outputFile << '\n';
     try {
@@ -275,7 +558,7 @@ int main(int argc, char **argv) {
       std::cerr << e.what() << '\n';
       exit(1);
     }
-  } else {
+  } else if (!outputFile.empty()) {
     std::cout << '\n' << "Replacements are stored in " << outputFile << "\n\n";
     std::cout << "To apply replacements, run:" << "\n\n";
     std::cout << "clang-xform -a " + outputFile << '\n';
@@ -22,63 +22,155 @@
   SOFTWARE.
 */
 
+#include "CoreUtil.hpp"
 #include "MatchCallbackDef.hpp"  // provides macro MATCH_CALLBACK to define a new match callback
 #include "MatcherFactory.hpp"   // a factory class used to register new matcher and callback
 #include "MatcherHelper.hpp"
+#include "MyASTMatchers.hpp"
 #include "ToolingUtil.hpp"      // APIs to extract locations and tokens for a given AST node
 
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
 
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/FileSystem.h"
+
 using namespace clang;
 using namespace clang::ast_matchers;
 
 namespace {
 // option1: qualified function name to match
 // option2: new function name to use
+// option3: file of "old,new" lines, one per function to rename
 const std::string option1 = "qualified-name";
 const std::string option2 = "new-name";
+const std::string option3 = "mapping-file";
+
+// load each version of the mapping file once, the map is shared by the
+// callbacks of all the threads. the file is keyed by its absolute path and
+// modification time, so that a server reloads it once edited
+std::shared_ptr<const QualifiedNameMap> LoadMappingFile(const std::string& path) {
+  static std::mutex mutex;
+  static std::map<std::string, std::shared_ptr<const QualifiedNameMap> > mappings;
+  std::string key = GetNormalizedPath(path);
+  llvm::sys::fs::file_status status;
+  if (!llvm::sys::fs::status(path, status)) {
+    key += '\0' + std::to_string(status.getSize()) + '\0' +
+        std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            status.getLastModificationTime().time_since_epoch()).count());
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  auto iter = mappings.find(key);
+  if (iter != mappings.end()) {
+    return iter->second;
+  }
+
+  std::ifstream ifs(path);
+  if (!ifs) {
+    throw CommandLineOptionException("Cannot open mapping file " + path);
+  }
+  auto mapping = std::make_shared<QualifiedNameMap>();
+  std::string line;
+  unsigned int lineNumber = 0;
+  while (std::getline(ifs, line)) {
+    ++lineNumber;
+    llvm::StringRef entry = llvm::StringRef(line).trim();
+    // skip empty lines and comments
+    if (entry.empty() || entry.startswith("#")) continue;
+    auto names = entry.split(',');
+    llvm::StringRef oldName = names.first.trim();
+    llvm::StringRef newName = names.second.trim();
+    if (oldName.empty() || newName.empty() || newName.contains(',')) {
+      throw CommandLineOptionException("Invalid line " + std::to_string(lineNumber) +
+                                       " in mapping file " + path + ", expected old,new");
+    }
+    mapping->insert(oldName.str(), newName.str());
+  }
+  return mappings.emplace(std::move(key), std::move(mapping)).first->second;
+}
 
-// Match callback class RenameFcnCallback is defined here
-OPTION_MATCH_CALLBACK(RenameFcnCallback);
+// RenameFcn only checks the callee name, so it visits the calls through the
+// callee table of the visitor dispatcher instead of running a matcher. Each
+// call only reaches the instances renaming its callee
+class RenameFcnCallback : public VisitorCallbackBase {
+ public :
+  explicit RenameFcnCallback(const std::string& id,
+                             clang::tooling::Replacements& replacements,
+                             std::vector<std::string> args)
+      : VisitorCallbackBase(id, replacements, std::move(args))
+  {}
+  virtual void RegisterVisitors(VisitorDispatcher* dispatcher) override;
+  virtual bool IsInterestingCallee(const FunctionDecl* callee) override;
+  virtual void VisitCall(const CallExpr* call, const FunctionDecl* callee,
+                         ASTContext& context) override;
+  virtual void RegisterOptions() override;
+  virtual void ParseOptions() override;
+  virtual std::vector<std::string> GetPrefilterTokens() const override;
+
+ private:
+  // names to rename, from the mapping file or --qualified-name and --new-name
+  std::shared_ptr<const QualifiedNameMap> mNames;
+};
 
 void RenameFcnCallback::RegisterOptions() {
   AddOption<std::string>(option1);
   AddOption<std::string>(option2);
+  AddOption<std::string>(option3);
 }
 
-void RenameFcnCallback::RegisterMatchers(clang::ast_matchers::MatchFinder* finder) {
-  StatementMatcher RenameFcnMatcher =
-      callExpr(callee(functionDecl(hasName(GetOption<std::string>(option1)))),
-               isExpansionInMainFile()
-               ).bind("RenameFcnExpr");
+void RenameFcnCallback::ParseOptions() {
+  MatchCallbackBase::ParseOptions();
+  if (HasOption(option3)) {
+    if (HasOption(option1) || HasOption(option2)) {
+      throw CommandLineOptionException("Options --" + option3 + " and --" + option1 +
+                                       "/--" + option2 + " of RenameFcn are mutually exclusive");
+    }
+    mNames = LoadMappingFile(GetOption<std::string>(option3));
+  } else if (HasOption(option1) || HasOption(option2)) {
+    auto names = std::make_shared<QualifiedNameMap>();
+    names->insert(GetOption<std::string>(option1), GetOption<std::string>(option2));
+    mNames = std::move(names);
+  }
+}
+
+std::vector<std::string> RenameFcnCallback::GetPrefilterTokens() const {
+  // the renamed calls spell the function name in the main file, except through macros
+  return mNames ? mNames->getUnqualifiedNames() : std::vector<std::string>();
+}
 
-  finder->addMatcher(RenameFcnMatcher, this);
+void RenameFcnCallback::RegisterVisitors(VisitorDispatcher* dispatcher) {
+  dispatcher->AddCalleeVisitor(this);
+  // only calls in the main file are matched
+  SetMainFileOnly();
 }
 
-// Definiation of RenameFcnCallback::run
-void RenameFcnCallback::run(const clang::ast_matchers::MatchFinder::MatchResult& Result) {
-  std::string oldExprString;
-  std::string newExprString;
-  const auto& srcMgr = Result.Context->getSourceManager();
-  const auto& langOpts = Result.Context->getLangOpts();
-
-  // Check any AST node matched for the given string ID.
-  // The node class name is usually the capitalized node matcher name.
-  if (const CallExpr* RenameFcnExpr =
-      Result.Nodes.getNodeAs<CallExpr>("RenameFcnExpr")) {
-    // find begin and end file locations of a given node
-    // use getExprLoc() for the begin loc which returns MemberLoc if it is a member function.
-    // i.e. X->F return F
-    auto locBegin = srcMgr.getFileLoc(RenameFcnExpr->getCallee()->getExprLoc());
-    auto locEnd = srcMgr.getFileLoc(RenameFcnExpr->getCallee()->getEndLoc());
-    newExprString = GetOption<std::string>(option2);
-    // find source text for a given location
-    oldExprString = getSourceText(locBegin, locEnd, srcMgr, langOpts);
-    // replace source text with a given string
-    ReplaceText(srcMgr, SourceRange(std::move(locBegin), std::move(locEnd)), newExprString);
-    // log the replacement or AST node if no replacement is made
-    LogReplacement(locBegin, srcMgr, oldExprString, newExprString);
+bool RenameFcnCallback::IsInterestingCallee(const FunctionDecl* callee) {
+  return mNames && mNames->lookup(*callee);
+}
+
+void RenameFcnCallback::VisitCall(const CallExpr* call, const FunctionDecl* callee,
+                                  ASTContext& context) {
+  const auto& srcMgr = context.getSourceManager();
+  const auto& langOpts = context.getLangOpts();
+  if (!IsExpansionInMainFile(call->getBeginLoc(), srcMgr)) {
+    return;
   }
+
+  // find begin and end file locations of a given node
+  // use getExprLoc() for the begin loc which returns MemberLoc if it is a member function.
+  // i.e. X->F return F
+  auto locBegin = srcMgr.getFileLoc(call->getCallee()->getExprLoc());
+  auto locEnd = srcMgr.getFileLoc(call->getCallee()->getEndLoc());
+  std::string newExprString = *mNames->lookup(*callee);
+  // find source text for a given location
+  std::string oldExprString = getSourceText(locBegin, locEnd, srcMgr, langOpts);
+  // replace source text with a given string
+  ReplaceText(srcMgr, SourceRange(std::move(locBegin), std::move(locEnd)), newExprString);
+  // log the replacement or AST node if no replacement is made
+  LogReplacement(locBegin, srcMgr, oldExprString, newExprString);
 }
 
 // register your own matcher and callback
@@ -0,0 +1,212 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CodeXformActionFactory.hpp"
+#include "MatchLimit.hpp"
+#include "MatcherFactory.hpp"
+#include "MemoryBudget.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Frontend/FrontendAction.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "gtest/gtest.h"
+
+using namespace clang::tooling;
+
+namespace {
+
+// factory sampling the resident set size before each file
+class SamplingActionFactory : public CodeXformActionFactory {
+ public:
+  using CodeXformActionFactory::CodeXformActionFactory;
+
+  clang::FrontendAction* create() override {
+    mSamples.push_back(GetCurrentRSS());
+    return CodeXformActionFactory::create();
+  }
+
+  const std::vector<uint64_t>& GetSamples() const { return mSamples; }
+
+ private:
+  std::vector<uint64_t> mSamples;
+};
+
+// callback counting its creations and resets
+class CountingMatchCallback : public MatchCallbackBase {
+ public:
+  explicit CountingMatchCallback(const std::string& id,
+                                 clang::tooling::Replacements& replacements,
+                                 std::vector<std::string> args)
+      : MatchCallbackBase(id, replacements, std::move(args))
+  {
+    ++sNumCreated;
+  }
+
+  void RegisterMatchers(clang::ast_matchers::MatchFinder* finder) override {}
+  void run(const clang::ast_matchers::MatchFinder::MatchResult &Result) override {}
+  void Reset() override { ++sNumResets; }
+
+  static int sNumCreated;
+  static int sNumResets;
+};
+
+int CountingMatchCallback::sNumCreated = 0;
+int CountingMatchCallback::sNumResets = 0;
+
+std::unique_ptr<MatchCallbackBase> CreateCountingMatchCallback(const std::string& id,
+                                                               clang::tooling::Replacements& replacements,
+                                                               std::vector<std::string> args) {
+  return std::make_unique<CountingMatchCallback>(id, replacements, std::move(args));
+}
+
+// source file with many functions calling the function to rename
+std::string GenerateSource(size_t numFunctions) {
+  std::ostringstream oss;
+  oss << "void Foo() {}\n";
+  for (size_t i = 0; i < numFunctions; ++i) {
+    oss << "int f" << i << "(int x) { Foo(); return x * " << i << "; }\n";
+  }
+  return oss.str();
+}
+
+size_t CountOccurrences(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + pattern.size())) {
+    ++count;
+  }
+  return count;
+}
+
+} // end anonymous namespace
+
+TEST(CodeXformActionTest, FlatMemory) {
+  std::string outputFile = "tmp_output_file.yaml";
+  std::vector<std::string> matchers = {"RenameFcn"};
+  std::vector<std::string> args = {"--matcher-args-RenameFcn", "--qualified-name", "Foo",
+                                   "--new-name", "Bar"};
+  FixedCompilationDatabase compilations(".", {"-std=c++11"});
+
+  // the freed memory is only given back with a memory budget, which also
+  // records the memory used by each file
+  CodeXformOptions options;
+  options.memoryBudget = std::make_shared<MemoryBudget>(1ull << 40);
+
+  // one tool processes all the files in sequence as a thread of ProcessFiles does
+  constexpr size_t numFiles = 40;
+  std::vector<std::string> files;
+  for (size_t i = 0; i < numFiles; ++i) {
+    files.push_back("/virtual/file" + std::to_string(i) + ".cpp");
+  }
+  ClangTool tool(compilations, files);
+  std::string source = GenerateSource(500);
+  for (const auto& file : files) {
+    tool.mapVirtualFile(file, source);
+  }
+  clang::IgnoringDiagConsumer diagConsumer;
+  tool.setDiagnosticConsumer(&diagConsumer);
+
+  SamplingActionFactory factory(outputFile, matchers, args, options);
+  ASSERT_EQ(tool.run(&factory), 0);
+  remove(outputFile.c_str());
+
+  // the memory of a file is released before the next one is processed, so the
+  // resident set size stays flat once the allocator is warmed up. retaining the
+  // memory of the files would grow it by the footprint of a file per file
+  const auto& samples = factory.GetSamples();
+  ASSERT_EQ(samples.size(), numFiles);
+  // resident set size is unknown on this platform
+  if (samples.front() == 0) {
+    return;
+  }
+  uint64_t footprint = options.memoryBudget->GetEstimate(files.front());
+  ASSERT_GT(footprint, 0u);
+  EXPECT_LT(samples.back(), samples[numFiles / 2] + footprint);
+}
+
+TEST(CodeXformActionTest, ReuseState) {
+  std::string id = "TestCodeXformAction";
+  MatcherFactory::Instance().RegisterMatchCallback(id, CreateCountingMatchCallback);
+  std::string outputFile = "tmp_output_file.yaml";
+  std::vector<std::string> matchers = {id};
+  std::vector<std::string> args;
+  FixedCompilationDatabase compilations(".", std::vector<std::string>());
+
+  std::vector<std::string> files = {"/virtual/a.cpp", "/virtual/b.cpp", "/virtual/c.cpp"};
+  ClangTool tool(compilations, files);
+  for (const auto& file : files) {
+    tool.mapVirtualFile(file, "int main() { return 0; }");
+  }
+  CodeXformActionFactory factory(outputFile, matchers, args);
+  ASSERT_EQ(tool.run(&factory), 0);
+  remove(outputFile.c_str());
+
+  // the callbacks are created once and reset after each file
+  EXPECT_EQ(CountingMatchCallback::sNumCreated, 1);
+  EXPECT_EQ(CountingMatchCallback::sNumResets, 3);
+}
+
+TEST(CodeXformActionTest, MaxMatches) {
+  std::string outputFile = "tmp_max_matches.yaml";
+  std::vector<std::string> matchers = {"RenameFcn"};
+  std::vector<std::string> args = {"--matcher-args-RenameFcn", "--qualified-name", "Foo",
+                                   "--new-name", "Bar"};
+  FixedCompilationDatabase compilations(".", {"-std=c++11"});
+  CodeXformOptions options;
+  options.matchLimit = std::make_shared<MatchLimit>(3);
+
+  // each file calls Foo twice, so the limit is reached within the second file
+  std::vector<std::string> files = {"/virtual/a.cpp", "/virtual/b.cpp", "/virtual/c.cpp"};
+  ClangTool tool(compilations, files);
+  for (const auto& file : files) {
+    tool.mapVirtualFile(file, GenerateSource(2));
+  }
+  remove(outputFile.c_str());
+  CodeXformActionFactory factory(outputFile, matchers, args, options);
+  testing::internal::CaptureStdout();
+  ASSERT_EQ(tool.run(&factory), 0);
+  std::string log = testing::internal::GetCapturedStdout();
+
+  std::ifstream ifs(outputFile);
+  std::string yaml((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  ifs.close();
+  remove(outputFile.c_str());
+
+  // the matches beyond the limit are neither edited nor logged
+  EXPECT_EQ(options.matchLimit->count(), 3u);
+  EXPECT_EQ(CountOccurrences(yaml, "ReplacementText: Bar"), 3u);
+  EXPECT_EQ(CountOccurrences(log, "Editting file:"), 3u);
+  // the file left once the limit is reached is skipped
+  EXPECT_NE(log.find("Processing file: /virtual/b.cpp"), std::string::npos);
+  EXPECT_EQ(log.find("Processing file: /virtual/c.cpp"), std::string::npos);
+  EXPECT_EQ(yaml.find("/virtual/c.cpp"), std::string::npos);
+}
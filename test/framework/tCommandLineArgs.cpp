@@ -173,6 +173,17 @@ TEST(CommandLineArgsTest, ValidateCommandLineArgs_InvalidMatcherArgs) {
   EXPECT_FALSE(ValidateCommandLineArgs(args, matcherArgs, false, errmsg));
 }
 
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_UnknownMatcherOption) {
+  std::string errmsg;
+  constexpr int argc = 5;
+  // error out when the matcher does not accept the given arguments
+  // args: clang_xform --input-files f --matchers RenameFcn --matcher-args-RenameFcn --abc 1
+  const char* argv[argc] = {"clang_xform", "--input-files", "f", "--matchers", "RenameFcn"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  std::vector<std::string> matcherArgs = {"--matcher-args-RenameFcn", "--abc", "1"};
+  EXPECT_FALSE(ValidateCommandLineArgs(args, matcherArgs, false, errmsg));
+}
+
 TEST(CommandLineArgsTest, ValidateCommandLineArgs_NoMatcher) {
   std::string errmsg;
   constexpr int argc = 3;
@@ -182,3 +193,257 @@ TEST(CommandLineArgsTest, ValidateCommandLineArgs_NoMatcher) {
   auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
   EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
 }
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_GenHeaderCompDB) {
+  std::string errmsg;
+  constexpr int argc = 4;
+  // args: clang_xform --gen-header-compdb -p compdb.json
+  const char* argv[argc] = {"clang_xform", "--gen-header-compdb", "-p", "compdb.json"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_GenHeaderCompDBWithOtherFlags) {
+  std::string errmsg;
+  // error out if --gen-header-compdb is used without --compile-commands
+  constexpr int argc1 = 2;
+  // args: clang_xform --gen-header-compdb
+  const char* argv1[argc1] = {"clang_xform", "--gen-header-compdb"};
+  auto args = ProcessCommandLine(argc1, const_cast<char**>(argv1));
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --gen-header-compdb is used with other flags
+  constexpr int argc2 = 6;
+  // args: clang_xform --gen-header-compdb -p compdb.json -m RenameFcn
+  const char* argv2[argc2] = {"clang_xform", "--gen-header-compdb", "-p", "compdb.json",
+                              "-m", "RenameFcn"};
+  args = ProcessCommandLine(argc2, const_cast<char**>(argv2));
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_Incremental) {
+  std::string errmsg;
+  constexpr int argc1 = 8;
+  // args: clang_xform --incremental -p compdb.json -m RenameFcn -o output.yaml
+  const char* argv1[argc1] = {"clang_xform", "--incremental", "-p", "compdb.json",
+                              "-m", "RenameFcn", "-o", "output.yaml"};
+  auto args = ProcessCommandLine(argc1, const_cast<char**>(argv1));
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --incremental is used without output file
+  args.outputFile.clear();
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --incremental is used without matchers
+  constexpr int argc2 = 4;
+  // args: clang_xform --incremental -p compdb.json
+  const char* argv2[argc2] = {"clang_xform", "--incremental", "-p", "compdb.json"};
+  args = ProcessCommandLine(argc2, const_cast<char**>(argv2));
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_Server) {
+  std::string errmsg;
+  constexpr int argc = 5;
+  // args: clang_xform --server xform.sock -p compdb.json
+  const char* argv[argc] = {"clang_xform", "--server", "xform.sock", "-p", "compdb.json"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --server is used with matchers
+  args.matchers = {"RenameFcn"};
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --server is used without --compile-commands
+  args.matchers.clear();
+  args.compileCommands.clear();
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_Connect) {
+  std::string errmsg;
+  constexpr int argc = 7;
+  // args: clang_xform --connect xform.sock -m RenameFcn -f f
+  const char* argv[argc] = {"clang_xform", "--connect", "xform.sock",
+                            "-m", "RenameFcn", "-f", "f"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --connect is used with --compile-commands
+  args.compileCommands = "compdb.json";
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_Watch) {
+  std::string errmsg;
+  constexpr int argc = 8;
+  // args: clang_xform --watch -p compdb.json -m RenameFcn -o output.yaml
+  const char* argv[argc] = {"clang_xform", "--watch", "-p", "compdb.json",
+                            "-m", "RenameFcn", "-o", "output.yaml"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --watch is used without --output
+  args.outputFile.clear();
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_MainFileScope) {
+  std::string errmsg;
+  constexpr int argc = 8;
+  // args: clang_xform --main-file-scope --scope-headers foo.hpp -m RenameFcn -f f
+  const char* argv[argc] = {"clang_xform", "--main-file-scope", "--scope-headers", "foo.hpp",
+                            "-m", "RenameFcn", "-f", "f"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_TRUE(args.mainFileScope);
+  EXPECT_EQ(args.scopeHeaders, std::vector<std::string>({"foo.hpp"}));
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --main-file-scope is used without --matchers
+  args.matchers.clear();
+  args.inputFiles.clear();
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_HeaderOwnership) {
+  std::string errmsg;
+  constexpr int argc = 6;
+  // args: clang_xform --header-ownership -p compdb.json -m RenameFcn
+  const char* argv[argc] = {"clang_xform", "--header-ownership", "-p", "compdb.json",
+                            "-m", "RenameFcn"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_TRUE(args.headerOwnership);
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --header-ownership is used with --incremental
+  args.incremental = true;
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --header-ownership is used without --compile-commands
+  args.incremental = false;
+  args.compileCommands.clear();
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_Preflight) {
+  std::string errmsg;
+  constexpr int argc = 4;
+  // args: clang_xform --preflight -p compdb.json
+  const char* argv[argc] = {"clang_xform", "--preflight", "-p", "compdb.json"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_TRUE(args.preflight);
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if --preflight is used with --matchers
+  args.matchers = {"RenameFcn"};
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_MemoryBudget) {
+  std::string errmsg;
+  constexpr int argc = 7;
+  // args: clang_xform --memory-budget 16G -p compdb.json -m RenameFcn
+  const char* argv[argc] = {"clang_xform", "--memory-budget", "16G", "-p", "compdb.json",
+                            "-m", "RenameFcn"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_EQ(args.memoryBudget, "16G");
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if the budget is not a size
+  args.memoryBudget = "16GB";
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_LoadMatchers) {
+  std::string errmsg;
+  constexpr int argc = 5;
+  // args: clang_xform --load-matchers a.so,b.so -m RenameFcn
+  const char* argv[argc] = {"clang_xform", "--load-matchers", "a.so,b.so", "-m", "RenameFcn"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_EQ(args.loadMatchers, std::vector<std::string>({"a.so", "b.so"}));
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if no matcher is applied or displayed
+  args.matchers.clear();
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  args.display = true;
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_Query) {
+  std::string errmsg;
+  constexpr int argc = 5;
+  // args: clang_xform --query callExpr() -p compdb.json
+  const char* argv[argc] = {"clang_xform", "--query", "callExpr()", "-p", "compdb.json"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  std::vector<std::string> matcherArgs;
+  EXPECT_TRUE(AdjustCommandLineArgs(args, matcherArgs));
+  EXPECT_EQ(args.matchers, std::vector<std::string>({"Query"}));
+  EXPECT_EQ(matcherArgs, std::vector<std::string>({"--matcher-args-Query", "--expression",
+                                                   "callExpr()"}));
+  EXPECT_TRUE(ValidateCommandLineArgs(args, matcherArgs, false, errmsg));
+  // error out if the expression cannot be parsed
+  matcherArgs.back() = "callExpr(";
+  EXPECT_FALSE(ValidateCommandLineArgs(args, matcherArgs, false, errmsg));
+  // error out if the matches would not be printed locally
+  matcherArgs.back() = "callExpr()";
+  args.incremental = true;
+  EXPECT_FALSE(ValidateCommandLineArgs(args, matcherArgs, false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_FindIndex) {
+  std::string errmsg;
+  constexpr int argc = 5;
+  // args: clang_xform --find-index hits.idx -m RenameFcn
+  const char* argv[argc] = {"clang_xform", "--find-index", "hits.idx", "-m", "RenameFcn"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_EQ(args.findIndex, "hits.idx");
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if replacements are exported as well
+  args.outputFile = "output.yaml";
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // --index-counts only reads an index
+  CommandLineArgs counts;
+  counts.indexCounts = "hits.idx";
+  EXPECT_TRUE(ValidateCommandLineArgs(counts, std::vector<std::string>(), false, errmsg));
+  counts.matchers = {"RenameFcn"};
+  EXPECT_FALSE(ValidateCommandLineArgs(counts, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_CountOnly) {
+  std::string errmsg;
+  constexpr int argc = 6;
+  // args: clang_xform --count-only -p compdb.json -m RenameFcn
+  const char* argv[argc] = {"clang_xform", "--count-only", "-p", "compdb.json", "-m", "RenameFcn"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_TRUE(args.countOnly);
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if replacements are exported as well
+  args.outputFile = "output.yaml";
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if no matcher is applied
+  args.outputFile.clear();
+  args.matchers.clear();
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_Sample) {
+  std::string errmsg;
+  constexpr int argc = 7;
+  // args: clang_xform --sample 0.02 -p compdb.json -m RenameFcn
+  const char* argv[argc] = {"clang_xform", "--sample", "0.02", "-p", "compdb.json",
+                            "-m", "RenameFcn"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_DOUBLE_EQ(args.sample, 0.02);
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if the sample is not a fraction
+  args.sample = 2;
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  args.sample = -0.5;
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
+
+TEST(CommandLineArgsTest, ValidateCommandLineArgs_MaxMatches) {
+  std::string errmsg;
+  constexpr int argc = 7;
+  // args: clang_xform --max-matches 10 -p compdb.json -m RenameFcn
+  const char* argv[argc] = {"clang_xform", "--max-matches", "10", "-p", "compdb.json",
+                            "-m", "RenameFcn"};
+  auto args = ProcessCommandLine(argc, const_cast<char**>(argv));
+  EXPECT_EQ(args.maxMatches, 10);
+  EXPECT_TRUE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if the limit is not positive
+  args.maxMatches = -1;
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+  // error out if only a sample of the files is processed
+  args.maxMatches = 10;
+  args.sample = 0.1;
+  EXPECT_FALSE(ValidateCommandLineArgs(args, std::vector<std::string>(), false, errmsg));
+}
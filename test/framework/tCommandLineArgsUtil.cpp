@@ -23,6 +23,7 @@
 */
 
 #include "CommandLineArgsUtil.hpp"
+#include "CoreUtil.hpp"
 
 #include "gtest/gtest.h"
 
@@ -75,3 +76,12 @@ TEST(CommandLineArgsUtilTest, GetMatcherArgs_MultipleConfig) {
   EXPECT_EQ(matcherArgs[0], baseline1);
   EXPECT_EQ(matcherArgs[1], baseline2);
 }
+
+TEST(CommandLineArgsUtilTest, MakePathArgsAbsolute) {
+  std::vector<std::string> args = {"--matcher-args-m", "--file", "a.txt", "--name", "b.txt",
+                                   "--matcher-args-m", "--file=c.txt", "--file", "/d.txt"};
+  std::vector<std::string> baseline = {"--matcher-args-m", "--file", GetNormalizedPath("a.txt"),
+                                       "--name", "b.txt", "--matcher-args-m",
+                                       "--file=" + GetNormalizedPath("c.txt"), "--file", "/d.txt"};
+  EXPECT_EQ(MakePathArgsAbsolute(args, {"--file"}), baseline);
+}
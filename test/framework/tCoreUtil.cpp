@@ -28,6 +28,8 @@
 #include <cstdio>
 
 #include "gtest/gtest.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 
 TEST(CoreUtilTest, ParseConfigFile_EqualityAsKeyDelimiter) {
   std::string configFile = "tmp.cfg";
@@ -121,3 +123,28 @@ TEST(CoreUtilTest, ParseConfigFileForMatcherArgs) {
                                        "--matcher-args-m2", "--ab=1","--cd=2"};
   EXPECT_EQ(res, baseline);
 }
+
+TEST(CoreUtilTest, PartitionFiles) {
+  EXPECT_TRUE(PartitionFiles(0, 4).empty());
+  // at least 3 files are processed by each thread
+  std::vector<std::pair<size_t, size_t> > baseline = {{0, 2}};
+  EXPECT_EQ(PartitionFiles(2, 8), baseline);
+  baseline = {{0, 10}};
+  EXPECT_EQ(PartitionFiles(10, 1), baseline);
+  // batches are consecutive and cover all the files
+  auto batches = PartitionFiles(100, 4);
+  ASSERT_FALSE(batches.empty());
+  EXPECT_EQ(batches.front().first, 0u);
+  EXPECT_EQ(batches.back().second, 100u);
+  for (size_t i = 1; i < batches.size(); ++i) {
+    EXPECT_EQ(batches[i].first, batches[i - 1].second);
+  }
+}
+
+TEST(CoreUtilTest, GetNormalizedPath) {
+  EXPECT_EQ(GetNormalizedPath("/src/./inc/../a.cpp"), "/src/a.cpp");
+  llvm::SmallString<256> cwd;
+  ASSERT_FALSE(llvm::sys::fs::current_path(cwd));
+  EXPECT_EQ(GetNormalizedPath("./a.cpp"), cwd.str().str() + "/a.cpp");
+  EXPECT_EQ(GetNormalizedPath("./a.cpp"), GetAbsolutePath(cwd.str().str(), "a.cpp"));
+}
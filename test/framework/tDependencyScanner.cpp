@@ -0,0 +1,46 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "DependencyScanner.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(DependencyScannerTest, ParseDependencyFile) {
+  std::string deps = "clang-scan-deps dependency: /src/foo.cpp /inc/a.hpp \\\n"
+                     "  /inc/b.hpp\n";
+  std::vector<std::string> baseline = {"/src/foo.cpp", "/inc/a.hpp", "/inc/b.hpp"};
+  EXPECT_EQ(ParseDependencyFile(deps), baseline);
+}
+
+TEST(DependencyScannerTest, ParseDependencyFile_EscapedCharacters) {
+  std::string deps = "foo.o: /src/foo.cpp /inc/my\\ dir/a.hpp \\\r\n"
+                     " /inc/\\#b.hpp /inc/$$c.hpp";
+  std::vector<std::string> baseline = {"/src/foo.cpp", "/inc/my dir/a.hpp",
+                                       "/inc/#b.hpp", "/inc/$c.hpp"};
+  EXPECT_EQ(ParseDependencyFile(deps), baseline);
+}
+
+TEST(DependencyScannerTest, ParseDependencyFile_NoTarget) {
+  EXPECT_TRUE(ParseDependencyFile("/src/foo.cpp /inc/a.hpp").empty());
+}
@@ -0,0 +1,121 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+#include "FileWatcher.hpp"
+#include "CoreUtil.hpp"
+
+#include <fstream>
+#include <map>
+
+#include "clang/Tooling/JSONCompilationDatabase.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "gtest/gtest.h"
+
+using namespace clang::tooling;
+using namespace llvm;
+
+#ifdef __linux__
+
+// fixture class for FileWatcher suite
+class FileWatcherTest : public ::testing::Test {
+ protected:
+  SmallString<256> dir;
+  std::string file;
+  std::string other;
+
+  void SetUp() override {
+    ASSERT_FALSE(sys::fs::createUniqueDirectory("clang-xform-watch", dir));
+    file = dir.str().str() + "/a.cpp";
+    other = dir.str().str() + "/b.cpp";
+    std::ofstream(file) << "int a;";
+    std::ofstream(other) << "int b;";
+  }
+
+  void TearDown() override {
+    sys::fs::remove_directories(dir);
+  }
+};
+
+TEST_F(FileWatcherTest, ReportChange) {
+  FileWatcher watcher;
+  watcher.Watch(file);
+  EXPECT_TRUE(watcher.IsWatched(file));
+  EXPECT_FALSE(watcher.IsWatched(other));
+
+  // modifications of files in the same directory which are not watched are ignored
+  std::ofstream(other) << "int b2;";
+  std::ofstream(file) << "int a2;";
+  EXPECT_EQ(watcher.WaitForChanges(), std::vector<std::string>({file}));
+}
+
+TEST_F(FileWatcherTest, Debounce) {
+  FileWatcher watcher;
+  watcher.Watch(file);
+  watcher.Watch(other);
+
+  // modifications within the interval are reported once
+  std::ofstream(file) << "int a2;";
+  std::ofstream(file) << "int a3;";
+  std::ofstream(other) << "int b2;";
+  EXPECT_EQ(watcher.WaitForChanges(), std::vector<std::string>({file, other}));
+
+  // files replaced on save are reported as well
+  std::string tmpFile = file + ".tmp";
+  std::ofstream(tmpFile) << "int a4;";
+  ASSERT_FALSE(sys::fs::rename(tmpFile, file));
+  EXPECT_EQ(watcher.WaitForChanges(), std::vector<std::string>({file}));
+}
+
+TEST_F(FileWatcherTest, UpdateReplacements) {
+  // the file is spelled relative to the directory of its compile command,
+  // while the input files are normalized as main.cpp does
+  std::string root = GetNormalizedPath(dir.str().str());
+  std::ofstream(file) << "void Foo() {}\nvoid f() { Foo(); }\n";
+  std::string errmsg;
+  auto compilations = JSONCompilationDatabase::loadFromBuffer(
+      "[{\"directory\": \"" + root + "\", \"command\": \"clang++ -c a.cpp\", \"file\": \"a.cpp\"}]",
+      errmsg, JSONCommandLineSyntax::AutoDetect);
+  ASSERT_TRUE(compilations != nullptr) << errmsg;
+  std::vector<std::string> inputFiles = {root + "/a.cpp"};
+  std::vector<std::string> matchers = {"RenameFcn"};
+  std::vector<std::string> matcherArgs = {"--matcher-args-RenameFcn", "--qualified-name", "Foo",
+                                          "--new-name", "Bar"};
+  std::string outputFile = root + "/output.yaml";
+
+  // a file processed again replaces its previous replacements
+  std::map<std::string, std::string> replacements;
+  for (int run = 0; run < 2; ++run) {
+    std::ofstream(outputFile).close();
+    ASSERT_EQ(ProcessFiles(*compilations, inputFiles, outputFile, matchers, matcherArgs, 1), 0);
+    UpdateReplacementsByFile(replacements, inputFiles, outputFile);
+    ASSERT_EQ(replacements.size(), 1u);
+    EXPECT_EQ(replacements.count(inputFiles.front()), 1u);
+    const std::string& document = replacements.begin()->second;
+    ASSERT_NE(document.find("ReplacementText: Bar"), std::string::npos);
+    EXPECT_EQ(document.find("ReplacementText: Bar"), document.rfind("ReplacementText: Bar"));
+  }
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "FindIndex.hpp"
+#include "CodeXformException.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+// fixture class for FindIndex suite
+class FindIndexTest : public ::testing::Test {
+ protected:
+  std::string indexFile;
+
+  void SetUp() override {
+    indexFile = "tmp_find_index.idx";
+  }
+
+  void TearDown() override {
+    remove(indexFile.c_str());
+  }
+};
+
+TEST_F(FindIndexTest, AppendAndRead) {
+  {
+    FindIndex index(indexFile);
+    FindIndexBlock block;
+    block.Add("M1", "/src/a.cpp", 10, 2, 3, "foo()");
+    block.Add("M2", "/src/a.cpp", 20, 4, 1, "");
+    index.Append(block);
+    EXPECT_TRUE(block.empty());
+    block.Add("M1", "/src/b/c.cpp", 30, 5, 7, "bar(x)");
+    index.Append(block);
+    EXPECT_EQ(index.size(), 3u);
+  }
+  std::vector<FindHit> hits;
+  ReadFindIndex(indexFile, [&hits](const FindHit& hit) {hits.push_back(hit);});
+  ASSERT_EQ(hits.size(), 3u);
+  EXPECT_EQ(hits[0].matcher, "M1");
+  EXPECT_EQ(hits[0].file, "/src/a.cpp");
+  EXPECT_EQ(hits[0].offset, 10u);
+  EXPECT_EQ(hits[0].line, 2u);
+  EXPECT_EQ(hits[0].column, 3u);
+  EXPECT_EQ(hits[0].snippet, "foo()");
+  EXPECT_EQ(hits[1].matcher, "M2");
+  EXPECT_EQ(hits[1].snippet, "");
+  EXPECT_EQ(hits[2].file, "/src/b/c.cpp");
+  EXPECT_EQ(hits[2].snippet, "bar(x)");
+}
+
+TEST_F(FindIndexTest, ParallelWriters) {
+  constexpr int numThreads = 4;
+  constexpr int numFiles = 10;
+  {
+    FindIndex index(indexFile);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+      threads.emplace_back([&index, i] {
+        FindIndexBlock block;
+        for (int j = 0; j < numFiles; ++j) {
+          std::string file = "/src/d" + std::to_string(i) + "/f" + std::to_string(j) + ".cpp";
+          block.Add("M1", file, 0, 1, 1, "x");
+          block.Add("M2", file, 5, 1, 6, "y");
+          index.Append(block);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  FindIndexCounts counts = CountFindIndex(indexFile);
+  EXPECT_EQ(counts.total, 2u * numThreads * numFiles);
+  EXPECT_EQ(counts.matchers["M1"], 1u * numThreads * numFiles);
+  EXPECT_EQ(counts.matchers["M2"], 1u * numThreads * numFiles);
+  EXPECT_EQ(counts.files.size(), 1u * numThreads * numFiles);
+  ASSERT_EQ(counts.directories.size(), 1u * numThreads);
+  EXPECT_EQ(counts.directories["/src/d0"], 2u * numFiles);
+}
+
+TEST_F(FindIndexTest, InvalidFile) {
+  std::ofstream ofs(indexFile);
+  ofs << "not an index";
+  ofs.close();
+  EXPECT_THROW(CountFindIndex(indexFile), FileSystemException);
+  // a truncated block is reported as well
+  {
+    FindIndex index(indexFile);
+    FindIndexBlock block;
+    block.Add("M1", "/src/a.cpp", 10, 2, 3, "foo()");
+    index.Append(block);
+  }
+  std::ifstream ifs(indexFile, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  ifs.close();
+  std::ofstream truncated(indexFile, std::ios::binary | std::ios::trunc);
+  truncated << content.substr(0, content.size() - 3);
+  truncated.close();
+  EXPECT_THROW(ReadFindIndex(indexFile, [](const FindHit&) {}), FileSystemException);
+}
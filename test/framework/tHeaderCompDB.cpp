@@ -0,0 +1,65 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "HeaderCompDB.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(HeaderCompDBTest, IsHeaderFile) {
+  EXPECT_TRUE(IsHeaderFile("/src/foo.h"));
+  EXPECT_TRUE(IsHeaderFile("/src/foo.hpp"));
+  EXPECT_FALSE(IsHeaderFile("/src/foo.cpp"));
+}
+
+TEST(HeaderCompDBTest, AssignHeadersToSources_SameStem) {
+  DependencyMap deps;
+  deps["/root/a/bar.cpp"] = {"/root/a/foo.hpp"};
+  deps["/root/b/foo.cpp"] = {"/root/a/foo.hpp"};
+  auto headerMap = AssignHeadersToSources(deps, "/root");
+  ASSERT_EQ(headerMap.size(), 1u);
+  EXPECT_EQ(headerMap["/root/a/foo.hpp"], "/root/b/foo.cpp");
+}
+
+TEST(HeaderCompDBTest, AssignHeadersToSources_ClosestSource) {
+  DependencyMap deps;
+  deps["/root/a/bar.cpp"] = {"/root/b/c/foo.hpp"};
+  deps["/root/b/baz.cpp"] = {"/root/b/c/foo.hpp"};
+  auto headerMap = AssignHeadersToSources(deps, "/root");
+  ASSERT_EQ(headerMap.size(), 1u);
+  EXPECT_EQ(headerMap["/root/b/c/foo.hpp"], "/root/b/baz.cpp");
+}
+
+TEST(HeaderCompDBTest, AssignHeadersToSources_CheapestSource) {
+  DependencyMap deps;
+  deps["/root/a/bar.cpp"] = {"/root/b/foo.hpp", "/root/b/baz.hpp"};
+  deps["/root/a/baz.cpp"] = {"/root/b/foo.hpp"};
+  auto headerMap = AssignHeadersToSources(deps, "/root");
+  EXPECT_EQ(headerMap["/root/b/foo.hpp"], "/root/a/baz.cpp");
+}
+
+TEST(HeaderCompDBTest, AssignHeadersToSources_OutsideRoot) {
+  DependencyMap deps;
+  deps["/root/a/bar.cpp"] = {"/usr/include/foo.h", "/rootdir/foo.h"};
+  EXPECT_TRUE(AssignHeadersToSources(deps, "/root").empty());
+}
@@ -0,0 +1,106 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "IncludeGraph.hpp"
+
+#include <cstdio>
+
+#include "gtest/gtest.h"
+
+// fixture class for IncludeGraph suite
+class IncludeGraphTest : public ::testing::Test {
+ protected:
+  IncludeGraph graph;
+  std::string graphFile;
+
+  void SetUp() override {
+    graphFile = "tmp_include_graph.txt";
+    graph.SetIncludedHeaders("/src/a.cpp", {"/inc/a.hpp", "/inc/common.hpp"}, 1);
+    graph.SetIncludedHeaders("/src/b.cpp", {"/inc/b.hpp", "/inc/common.hpp"}, 2);
+  }
+
+  void TearDown() override {
+    remove(graphFile.c_str());
+  }
+};
+
+TEST_F(IncludeGraphTest, GetIncludedHeaders) {
+  std::vector<std::string> baseline = {"/inc/a.hpp", "/inc/common.hpp"};
+  EXPECT_EQ(graph.GetIncludedHeaders("/src/a.cpp"), baseline);
+  EXPECT_TRUE(graph.GetIncludedHeaders("/src/c.cpp").empty());
+}
+
+TEST_F(IncludeGraphTest, GetIncludingFiles) {
+  std::vector<std::string> baseline = {"/src/a.cpp", "/src/b.cpp"};
+  EXPECT_EQ(graph.GetIncludingFiles("/inc/common.hpp"), baseline);
+  baseline = {"/src/b.cpp"};
+  EXPECT_EQ(graph.GetIncludingFiles("/inc/b.hpp"), baseline);
+  EXPECT_TRUE(graph.GetIncludingFiles("/inc/c.hpp").empty());
+}
+
+TEST_F(IncludeGraphTest, UpdateIncludedHeaders) {
+  graph.SetIncludedHeaders("/src/a.cpp", {"/inc/b.hpp"}, 3);
+  std::vector<std::string> baseline = {"/src/b.cpp"};
+  EXPECT_EQ(graph.GetIncludingFiles("/inc/common.hpp"), baseline);
+  baseline = {"/src/a.cpp", "/src/b.cpp"};
+  EXPECT_EQ(graph.GetIncludingFiles("/inc/b.hpp"), baseline);
+  EXPECT_TRUE(graph.GetIncludingFiles("/inc/a.hpp").empty());
+}
+
+TEST_F(IncludeGraphTest, SaveAndLoad) {
+  graph.Save(graphFile);
+  IncludeGraph loaded;
+  ASSERT_TRUE(loaded.Load(graphFile));
+  EXPECT_EQ(loaded.GetFiles(), graph.GetFiles());
+  EXPECT_TRUE(loaded.HasFile("/src/a.cpp"));
+  EXPECT_FALSE(loaded.HasFile("/inc/a.hpp"));
+  EXPECT_EQ(loaded.GetIncludedHeaders("/src/b.cpp"), graph.GetIncludedHeaders("/src/b.cpp"));
+  EXPECT_EQ(loaded.GetIncludingFiles("/inc/common.hpp"),
+            graph.GetIncludingFiles("/inc/common.hpp"));
+}
+
+TEST_F(IncludeGraphTest, LoadMissingFile) {
+  IncludeGraph loaded;
+  EXPECT_FALSE(loaded.Load("not_exist.txt"));
+  EXPECT_TRUE(loaded.GetFiles().empty());
+}
+
+TEST_F(IncludeGraphTest, GetHeaderOwners) {
+  graph.SetIncludedHeaders("/src/c.cpp", {"/inc/a.hpp", "/inc/c.hpp", "/inc/common.hpp"}, 3);
+  auto owners = GetHeaderOwners(graph, {"/src/a.cpp", "/src/b.cpp", "/src/c.cpp"});
+  EXPECT_EQ(owners.size(), 4u);
+  // shared headers are owned by the cheapest file reaching them
+  EXPECT_EQ(owners["/inc/a.hpp"], "/src/a.cpp");
+  EXPECT_EQ(owners["/inc/common.hpp"], "/src/a.cpp");
+  EXPECT_EQ(owners["/inc/b.hpp"], "/src/b.cpp");
+  EXPECT_EQ(owners["/inc/c.hpp"], "/src/c.cpp");
+  // headers are only owned by the given files
+  owners = GetHeaderOwners(graph, {"/src/b.cpp", "/src/c.cpp"});
+  EXPECT_EQ(owners["/inc/common.hpp"], "/src/b.cpp");
+  EXPECT_EQ(owners["/inc/a.hpp"], "/src/c.cpp");
+  // owners are normalized as the paths of the include graph
+  owners = GetHeaderOwners(graph, {"/src/./b.cpp", "/src/inc/../c.cpp"});
+  EXPECT_EQ(owners["/inc/common.hpp"], "/src/b.cpp");
+  EXPECT_EQ(owners["/inc/a.hpp"], "/src/c.cpp");
+}
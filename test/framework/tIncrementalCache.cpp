@@ -0,0 +1,220 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "IncrementalCache.hpp"
+#include "IncludeGraph.hpp"
+#include "CoreUtil.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <memory>
+
+#include "clang/Tooling/JSONCompilationDatabase.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+
+#include "gtest/gtest.h"
+
+using namespace clang::tooling;
+using namespace llvm;
+
+namespace {
+
+std::string ReadFile(const std::string& file) {
+  std::ifstream ifs(file);
+  return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+}
+
+size_t CountOccurrences(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string::npos;
+       pos = text.find(pattern, pos + pattern.size())) {
+    ++count;
+  }
+  return count;
+}
+
+} // end anonymous namespace
+
+// fixture class for IncrementalCache suite
+class IncrementalCacheTest : public ::testing::Test {
+ protected:
+  IncludeGraph graph;
+  RunManifest previous;
+  RunManifest current;
+  std::vector<std::string> files;
+  std::string manifestFile;
+
+  void SetUp() override {
+    manifestFile = "tmp_manifest.txt";
+    files = {"/src/a.cpp", "/src/b.cpp"};
+    graph.SetIncludedHeaders("/src/a.cpp", {"/inc/a.hpp", "/inc/common.hpp"}, 1);
+    graph.SetIncludedHeaders("/src/b.cpp", {"/inc/b.hpp", "/inc/common.hpp"}, 1);
+    for (auto manifest : {&previous, &current}) {
+      manifest->SetSignature("signature");
+      for (const auto& file : {"/src/a.cpp", "/src/b.cpp", "/inc/a.hpp",
+                               "/inc/b.hpp", "/inc/common.hpp"}) {
+        manifest->SetFileHash(file, std::string("h") + file);
+      }
+      for (const auto& file : files) {
+        manifest->SetCommandHash(file, "c" + file);
+      }
+    }
+  }
+
+  void TearDown() override {
+    remove(manifestFile.c_str());
+  }
+};
+
+TEST_F(IncrementalCacheTest, NothingChanged) {
+  EXPECT_TRUE(SelectAffectedFiles(previous, current, graph, files).empty());
+}
+
+TEST_F(IncrementalCacheTest, SourceChanged) {
+  current.SetFileHash("/src/b.cpp", "h");
+  std::vector<std::string> baseline = {"/src/b.cpp"};
+  EXPECT_EQ(SelectAffectedFiles(previous, current, graph, files), baseline);
+}
+
+TEST_F(IncrementalCacheTest, HeaderChanged) {
+  current.SetFileHash("/inc/a.hpp", "h");
+  std::vector<std::string> baseline = {"/src/a.cpp"};
+  EXPECT_EQ(SelectAffectedFiles(previous, current, graph, files), baseline);
+  current.SetFileHash("/inc/common.hpp", "h");
+  EXPECT_EQ(SelectAffectedFiles(previous, current, graph, files), files);
+}
+
+TEST_F(IncrementalCacheTest, CommandChanged) {
+  current.SetCommandHash("/src/a.cpp", "c");
+  std::vector<std::string> baseline = {"/src/a.cpp"};
+  EXPECT_EQ(SelectAffectedFiles(previous, current, graph, files), baseline);
+}
+
+TEST_F(IncrementalCacheTest, SignatureChanged) {
+  current.SetSignature("signature2");
+  EXPECT_EQ(SelectAffectedFiles(previous, current, graph, files), files);
+  EXPECT_EQ(SelectAffectedFiles(RunManifest(), current, graph, files), files);
+}
+
+TEST_F(IncrementalCacheTest, Merge) {
+  // this run only processes a.cpp
+  RunManifest run;
+  run.SetSignature("signature");
+  run.SetFileHash("/src/a.cpp", "h2");
+  run.SetCommandHash("/src/a.cpp", "c2");
+  EXPECT_TRUE(run.Merge(previous, graph).empty());
+  EXPECT_EQ(run.GetFileHash("/src/a.cpp"), "h2");
+  EXPECT_EQ(run.GetCommandHash("/src/a.cpp"), "c2");
+  EXPECT_EQ(run.GetFileHash("/inc/b.hpp"), "h/inc/b.hpp");
+  EXPECT_EQ(run.GetCommandHash("/src/b.cpp"), "c/src/b.cpp");
+  // b.cpp stays unaffected in the next run
+  std::vector<std::string> baseline = {"/src/a.cpp"};
+  EXPECT_EQ(SelectAffectedFiles(previous, run, graph, files), baseline);
+
+  // the entries of another signature are dropped
+  RunManifest other;
+  other.SetSignature("signature2");
+  other.Merge(previous, graph);
+  EXPECT_TRUE(other.GetCommandHash("/src/b.cpp").empty());
+}
+
+TEST_F(IncrementalCacheTest, MergeChangedHeader) {
+  // this run only processes a.cpp, after common.hpp changed
+  RunManifest run;
+  run.SetSignature("signature");
+  run.SetFileHash("/src/a.cpp", "h/src/a.cpp");
+  run.SetFileHash("/inc/common.hpp", "h2");
+  run.SetCommandHash("/src/a.cpp", "c/src/a.cpp");
+  // b.cpp reaches common.hpp, so its cached replacements are stale
+  std::vector<std::string> baseline = {"/src/b.cpp"};
+  EXPECT_EQ(run.Merge(previous, graph), baseline);
+  EXPECT_TRUE(run.GetCommandHash("/src/b.cpp").empty());
+  EXPECT_EQ(run.GetFileHash("/inc/common.hpp"), "h2");
+  // and b.cpp is processed by the next run even though nothing changed since
+  current.SetFileHash("/inc/common.hpp", "h2");
+  EXPECT_EQ(SelectAffectedFiles(run, current, graph, files), baseline);
+
+  // the files unknown to the include graph are dropped too
+  RunManifest other;
+  other.SetSignature("signature");
+  EXPECT_EQ(other.Merge(previous, IncludeGraph()), files);
+}
+
+TEST_F(IncrementalCacheTest, SaveAndLoad) {
+  current.SetFileHash("/path with space/c.hpp", "hc");
+  current.Save(manifestFile);
+  RunManifest loaded;
+  ASSERT_TRUE(loaded.Load(manifestFile));
+  EXPECT_EQ(loaded.GetSignature(), "signature");
+  EXPECT_EQ(loaded.GetFileHash("/path with space/c.hpp"), "hc");
+  EXPECT_EQ(loaded.GetCommandHash("/src/a.cpp"), "c/src/a.cpp");
+  EXPECT_TRUE(loaded.GetCommandHash("/inc/a.hpp").empty());
+  EXPECT_FALSE(loaded.Load("not_exist.txt"));
+}
+
+TEST_F(IncrementalCacheTest, HashFile) {
+  std::ofstream(manifestFile) << "content";
+  auto hash = HashFile(manifestFile);
+  EXPECT_EQ(hash.size(), 32u);
+  EXPECT_EQ(HashFiles({manifestFile, "not_exist.txt"}, 2),
+            std::vector<std::string>({hash, std::string()}));
+}
+
+TEST_F(IncrementalCacheTest, RelativeCompileCommand) {
+  SmallString<256> dir;
+  ASSERT_FALSE(sys::fs::createUniqueDirectory("clang-xform-incremental", dir));
+  std::string root = GetNormalizedPath(dir.str().str());
+  for (const auto& name : {"a.cpp", "b.cpp"}) {
+    std::ofstream(root + "/" + name) << "void Foo() {}\nvoid f() { Foo(); }\n";
+  }
+  // the files are spelled relative to the directory of their compile commands,
+  // while the input files are normalized as main.cpp does
+  std::string errmsg;
+  auto compilations = JSONCompilationDatabase::loadFromBuffer(
+      "[{\"directory\": \"" + root + "\", \"command\": \"clang++ -c a.cpp\", \"file\": \"a.cpp\"},"
+      " {\"directory\": \"" + root + "\", \"command\": \"clang++ -c b.cpp\", \"file\": \"b.cpp\"}]",
+      errmsg, JSONCommandLineSyntax::AutoDetect);
+  ASSERT_TRUE(compilations != nullptr) << errmsg;
+  std::vector<std::string> inputFiles = {root + "/a.cpp", root + "/b.cpp"};
+  std::vector<std::string> matchers = {"RenameFcn"};
+  std::vector<std::string> matcherArgs = {"--matcher-args-RenameFcn", "--qualified-name", "Foo",
+                                          "--new-name", "Bar"};
+  std::string outputFile = root + "/output.yaml";
+  std::string cacheDir = root + "/cache";
+
+  // the second run processes no file and takes all the replacements from the cache
+  for (int run = 0; run < 2; ++run) {
+    std::ofstream(outputFile).close();
+    ASSERT_EQ(ProcessFilesIncrementally(*compilations, inputFiles, outputFile,
+                                        matchers, matcherArgs, 1, cacheDir), 0);
+    std::string yaml = ReadFile(outputFile);
+    EXPECT_EQ(CountOccurrences(yaml, "ReplacementText: Bar"), 2u) << run << yaml;
+    // the replacements are keyed by the normalized path of the main file
+    auto replacements = ReadReplacementsByFile(outputFile);
+    EXPECT_EQ(replacements.size(), 2u);
+    EXPECT_EQ(replacements.count(inputFiles.front()), 1u);
+  }
+  sys::fs::remove_directories(root);
+}
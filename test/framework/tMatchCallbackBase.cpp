@@ -52,10 +52,14 @@ class MatchCallbackForTest : public MatchCallbackBase {
   }
 
   template <typename T>
-  T GetOption(const std::string& key) {
+  const T& GetOption(const std::string& key) {
     return MatchCallbackBase::GetOption<T>(key);
   }
 
+  void SetMainFileOnly(bool mainFileOnly = true) {
+    MatchCallbackBase::SetMainFileOnly(mainFileOnly);
+  }
+
 };
 
 } // end of anonymous namespace
@@ -160,6 +164,55 @@ TEST_F(MatchCallbackBaseTest, OptionNotExist) {
                cxxopts::option_not_exists_exception);
 }
 
+TEST_F(MatchCallbackBaseTest, SharedOptionTable) {
+  // "--matcher-args-Test --key1 value1"
+  std::vector<std::string> args = {sep, "--" + key1, value1};
+  MatchCallbackForTest matchCallback1(matcherName, replacements, args);
+  matchCallback1.AddOption<std::string>(key1);
+  matchCallback1.AddOption<std::string>(key2, value2);
+  matchCallback1.ParseOptions();
+  MatchCallbackForTest matchCallback2(matcherName, replacements, args);
+  matchCallback2.AddOption<std::string>(key1);
+  matchCallback2.AddOption<std::string>(key2, value2);
+  matchCallback2.ParseOptions();
+
+  // instances with the same arguments and options share the parsed values
+  EXPECT_EQ(&matchCallback1.GetOption<std::string>(key1),
+            &matchCallback2.GetOption<std::string>(key1));
+  EXPECT_EQ(matchCallback2.GetOption<std::string>(key2), value2);
+
+  // instances with other options parse the arguments again
+  MatchCallbackForTest matchCallback3(matcherName, replacements, args);
+  matchCallback3.AddOption<std::string>(key1);
+  matchCallback3.ParseOptions();
+  EXPECT_EQ(matchCallback3.GetOption<std::string>(key1), value1);
+  EXPECT_THROW(matchCallback3.GetOption<std::string>(key2),
+               cxxopts::option_not_present_exception);
+
+  // instances created after the tables are cleared parse the arguments again,
+  // while the existing ones keep their values
+  ClearMatcherOptions();
+  MatchCallbackForTest matchCallback4(matcherName, replacements, args);
+  matchCallback4.AddOption<std::string>(key1);
+  matchCallback4.AddOption<std::string>(key2, value2);
+  matchCallback4.ParseOptions();
+  EXPECT_NE(&matchCallback1.GetOption<std::string>(key1),
+            &matchCallback4.GetOption<std::string>(key1));
+  EXPECT_EQ(matchCallback1.GetOption<std::string>(key1), value1);
+  EXPECT_EQ(matchCallback4.GetOption<std::string>(key1), value1);
+}
+
+TEST_F(MatchCallbackBaseTest, OptionTypeMismatch) {
+  // "--matcher-args-Test --key1 1"
+  std::vector<std::string> args = {sep, "--" + key1, "1"};
+  MatchCallbackForTest matchCallback(matcherName, replacements, args);
+  matchCallback.AddOption<int>(key1);
+  matchCallback.ParseOptions();
+
+  EXPECT_EQ(matchCallback.GetOption<int>(key1), 1);
+  EXPECT_THROW(matchCallback.GetOption<std::string>(key1), CommandLineOptionException);
+}
+
 TEST_F(MatchCallbackBaseTest, RegisterOrder) {
   clang::ast_matchers::MatchFinder* finder = nullptr;
   std::vector<std::string> args;
@@ -174,3 +227,12 @@ TEST_F(MatchCallbackBaseTest, RegisterOrder) {
 
   matchCallback.Register(finder);
 }
+
+TEST_F(MatchCallbackBaseTest, MainFileOnly) {
+  MatchCallbackForTest matchCallback(matcherName, replacements, std::vector<std::string>());
+  EXPECT_FALSE(matchCallback.IsMainFileOnly());
+  matchCallback.SetMainFileOnly();
+  EXPECT_TRUE(matchCallback.IsMainFileOnly());
+  matchCallback.SetMainFileOnly(false);
+  EXPECT_FALSE(matchCallback.IsMainFileOnly());
+}
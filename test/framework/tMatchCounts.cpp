@@ -0,0 +1,70 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "MatchCounts.hpp"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(MatchCountsTest, Add) {
+  MatchCounts counts;
+  counts.Add("M1", "/src/a.cpp", 2);
+  counts.Add("M2", "/src/a.cpp", 1);
+  counts.Add("M1", "/src/b.cpp", 3);
+  EXPECT_EQ(counts.total(), 6u);
+  EXPECT_EQ(counts.matchers().at("M1"), 5u);
+  EXPECT_EQ(counts.matchers().at("M2"), 1u);
+  EXPECT_EQ(counts.files().at("/src/a.cpp"), 3u);
+  EXPECT_EQ(counts.files().at("/src/b.cpp"), 3u);
+
+  std::ostringstream oss;
+  PrintMatchCounts(counts, oss);
+  EXPECT_NE(oss.str().find("Matches: 6"), std::string::npos);
+  EXPECT_NE(oss.str().find("         5  M1"), std::string::npos);
+  EXPECT_NE(oss.str().find("         3  /src/b.cpp"), std::string::npos);
+}
+
+TEST(MatchCountsTest, ParallelAdd) {
+  constexpr int numThreads = 4;
+  constexpr int numFiles = 100;
+  MatchCounts counts;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; ++i) {
+    threads.emplace_back([&counts, i] {
+      for (int j = 0; j < numFiles; ++j) {
+        counts.Add("M" + std::to_string(i), "/src/f" + std::to_string(j) + ".cpp", 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counts.total(), 1u * numThreads * numFiles);
+  EXPECT_EQ(counts.matchers().size(), 1u * numThreads);
+  EXPECT_EQ(counts.files().size(), 1u * numFiles);
+  EXPECT_EQ(counts.files().at("/src/f0.cpp"), 1u * numThreads);
+}
@@ -0,0 +1,64 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "MatchLimit.hpp"
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(MatchLimitTest, Add) {
+  MatchLimit limit(2);
+  EXPECT_FALSE(limit.Reached());
+  EXPECT_TRUE(limit.Add());
+  EXPECT_TRUE(limit.Add());
+  EXPECT_TRUE(limit.Reached());
+  EXPECT_FALSE(limit.Add());
+  EXPECT_EQ(limit.count(), 2u);
+}
+
+TEST(MatchLimitTest, ParallelAdd) {
+  constexpr int numThreads = 4;
+  MatchLimit limit(1000);
+  std::vector<int> accepted(numThreads, 0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; ++i) {
+    threads.emplace_back([&limit, &accepted, i] {
+      for (int j = 0; j < 1000; ++j) {
+        accepted[i] += limit.Add();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // exactly the limit is accepted over all the threads
+  int sum = 0;
+  for (auto count : accepted) {
+    sum += count;
+  }
+  EXPECT_EQ(sum, 1000);
+  EXPECT_EQ(limit.count(), 1000u);
+}
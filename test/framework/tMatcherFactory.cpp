@@ -24,6 +24,15 @@
 
 #include "MatcherFactory.hpp"
 #include "MockMatchCallback.hpp"
+#include "CodeXformActionFactory.hpp"
+#include "CodeXformException.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
 
 #include "gtest/gtest.h"
 
@@ -48,3 +57,53 @@ TEST(MatcherFactoryTest, CreateMatchCallback) {
   ASSERT_TRUE(factory.getMatcherMap().count(id));
   EXPECT_TRUE(factory.getMatcherMap().at(id) == CreateMockMatchCallback);
 }
+
+TEST(MatcherFactoryTest, LoadPlugin) {
+  MatcherFactory& factory = MatcherFactory::Instance();
+  EXPECT_THROW(factory.LoadPlugin("/nonexistent/plugin.so"), FileSystemException);
+  // a library without matchers
+  EXPECT_THROW(factory.LoadPlugin("libc.so.6"), CommandLineOptionException);
+  EXPECT_TRUE(factory.getPlugins().empty());
+}
+
+#ifdef TEST_PLUGIN
+TEST(MatcherFactoryTest, LoadPluginMatcher) {
+  MatcherFactory& factory = MatcherFactory::Instance();
+  factory.LoadPlugin(TEST_PLUGIN);
+  EXPECT_TRUE(factory.getMatcherMap().count("PluginRename"));
+  EXPECT_EQ(factory.getPlugins(), std::vector<std::string>({TEST_PLUGIN}));
+
+  // the matcher of the plugin runs like a built-in one
+  std::string outputFile = "tmp_plugin_output.yaml";
+  std::vector<std::string> matchers = {"PluginRename"};
+  std::vector<std::string> args;
+  clang::tooling::FixedCompilationDatabase compilations(".", std::vector<std::string>());
+  std::vector<std::string> files = {"/virtual/plugin.cpp"};
+  clang::tooling::ClangTool tool(compilations, files);
+  tool.mapVirtualFile(files.front(), "void PluginFoo();\nvoid f() { PluginFoo(); }\n");
+  CodeXformActionFactory actionFactory(outputFile, matchers, args);
+  ASSERT_EQ(tool.run(&actionFactory), 0);
+
+  std::ifstream ifs(outputFile);
+  std::string yaml((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  remove(outputFile.c_str());
+  EXPECT_NE(yaml.find("ReplacementText: PluginBar"), std::string::npos);
+}
+#endif
+
+#ifdef TEST_DUPLICATE_PLUGIN
+TEST(MatcherFactoryTest, LoadPluginDuplicateMatcher) {
+  MatcherFactory& factory = MatcherFactory::Instance();
+  auto createRenameFcn = factory.getMatcherMap().at("RenameFcn");
+  // the plugin registers a new ID and the ID of RenameFcn, which is reported
+  try {
+    factory.LoadPlugin(TEST_DUPLICATE_PLUGIN);
+    FAIL() << "duplicate matcher ID is not reported";
+  }
+  catch (CommandLineOptionException& e) {
+    EXPECT_NE(std::string(e.what()).find("RenameFcn"), std::string::npos) << e.what();
+  }
+  EXPECT_TRUE(factory.getMatcherMap().count("PluginDuplicate"));
+  EXPECT_EQ(factory.getMatcherMap().at("RenameFcn"), createRenameFcn);
+}
+#endif
@@ -0,0 +1,120 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "MemoryBudget.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+TEST(MemoryBudgetTest, ParseMemorySize) {
+  uint64_t bytes = 0;
+  EXPECT_TRUE(ParseMemorySize("1024", bytes));
+  EXPECT_EQ(bytes, 1024u);
+  EXPECT_TRUE(ParseMemorySize("512M", bytes));
+  EXPECT_EQ(bytes, 512u << 20);
+  EXPECT_TRUE(ParseMemorySize("16g", bytes));
+  EXPECT_EQ(bytes, 16ull << 30);
+  EXPECT_FALSE(ParseMemorySize("", bytes));
+  EXPECT_FALSE(ParseMemorySize("G", bytes));
+  EXPECT_FALSE(ParseMemorySize("16GB", bytes));
+  EXPECT_FALSE(ParseMemorySize("16T", bytes));
+  // sizes overflowing 64 bits
+  EXPECT_TRUE(ParseMemorySize("18446744073709551615", bytes));
+  EXPECT_EQ(bytes, 18446744073709551615ull);
+  EXPECT_FALSE(ParseMemorySize("18446744073709551616", bytes));
+  EXPECT_TRUE(ParseMemorySize("17179869183G", bytes));
+  EXPECT_EQ(bytes, 17179869183ull << 30);
+  EXPECT_FALSE(ParseMemorySize("17179869184G", bytes));
+  EXPECT_FALSE(ParseMemorySize("99999999999999G", bytes));
+}
+
+TEST(MemoryBudgetTest, GetCurrentRSS) {
+#ifdef __linux__
+  EXPECT_GT(GetCurrentRSS(), 0u);
+#endif
+}
+
+TEST(MemoryBudgetTest, GetEstimate) {
+  MemoryBudget budget(1000, 10);
+  // the default estimate is used without history
+  EXPECT_EQ(budget.GetEstimate("/src/a.cpp"), 10u);
+  budget.Acquire("/src/a.cpp");
+  budget.Release("/src/a.cpp", 100);
+  budget.Acquire("/src/b.cpp");
+  budget.Release("/src/b.cpp", 300);
+  EXPECT_EQ(budget.GetEstimate("/src/a.cpp"), 100u);
+  // files without history are as large as the average file
+  EXPECT_EQ(budget.GetEstimate("/src/c.cpp"), 200u);
+}
+
+TEST(MemoryBudgetTest, AcquireSameFile) {
+  MemoryBudget budget(1ull << 60, 10);
+  // a file compiled with several commands is reserved once per run
+  budget.Acquire("/src/a.cpp");
+  budget.Acquire("/src/a.cpp");
+  EXPECT_EQ(budget.GetReserved(), 20u);
+  budget.Release("/src/a.cpp", 0);
+  EXPECT_EQ(budget.GetReserved(), 10u);
+  budget.Release("/src/a.cpp", 0);
+  EXPECT_EQ(budget.GetReserved(), 0u);
+  // releasing a file not in flight is ignored
+  budget.Release("/src/a.cpp", 0);
+  EXPECT_EQ(budget.GetReserved(), 0u);
+}
+
+TEST(MemoryBudgetTest, SaveAndLoad) {
+  std::string file = "tmp_memory_history.txt";
+  MemoryBudget budget(1000);
+  budget.Acquire("/src/a b.cpp");
+  budget.Release("/src/a b.cpp", 100);
+  budget.Save(file);
+  MemoryBudget loaded(1000);
+  ASSERT_TRUE(loaded.Load(file));
+  EXPECT_EQ(loaded.GetEstimate("/src/a b.cpp"), 100u);
+  remove(file.c_str());
+  EXPECT_FALSE(loaded.Load(file));
+}
+
+TEST(MemoryBudgetTest, Acquire) {
+  // the budget is far below the resident set size of the process
+  MemoryBudget budget(1);
+  // a file is always admitted when nothing else is in flight
+  budget.Acquire("/src/a.cpp");
+  std::atomic<bool> admitted(false);
+  std::thread thread([&budget, &admitted]() {
+    budget.Acquire("/src/b.cpp");
+    admitted = true;
+    budget.Release("/src/b.cpp", 0);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_FALSE(admitted);
+  // the pending file is admitted once the memory is released
+  budget.Release("/src/a.cpp", 0);
+  thread.join();
+  EXPECT_TRUE(admitted);
+}
@@ -0,0 +1,163 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "MyASTMatchers.hpp"
+
+#include <memory>
+#include <string>
+
+#include "clang/ASTMatchers/ASTMatchFinder.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "gtest/gtest.h"
+
+using namespace clang;
+using namespace clang::ast_matchers;
+
+namespace {
+
+const std::string code = R"(
+typedef int SLSize;
+typedef unsigned long size_t;
+namespace std {
+template <typename T> struct vector { T& operator[](size_t); };
+}
+bool DimLess(SLSize, SLSize);
+SLSize DimValue2SLSize(int);
+SLSize GetSLSize();
+void f(SLSize a, int b, size_t c, std::vector<SLSize>& v) {
+  SLSize d = a + b;
+  int e = b * 2;
+  size_t g = c;
+  DimLess(a, d);
+  DimValue2SLSize(e);
+  SLSize h = v[0];
+  auto n = GetSLSize();
+  int i = n;
+}
+)";
+
+const std::string scopeCode = R"(
+namespace ns {
+void Baz();
+namespace inner { void Baz(); }
+}
+namespace std { inline namespace __1 { void f(); } }
+namespace { void h(); }
+template <typename T> struct Foo { void bar(); };
+template struct Foo<int>;
+void Baz();
+void g() { void Local(); }
+)";
+
+template <typename MatcherT>
+size_t CountMatches(ASTUnit& ast, const MatcherT& matcher) {
+  return match(matcher, ast.getASTContext()).size();
+}
+
+// number of functions matched by a map with the given name only
+size_t CountNameInMatches(ASTUnit& ast, const std::string& name) {
+  auto names = std::make_shared<QualifiedNameMap>();
+  names->insert(name, "value");
+  return CountMatches(ast, functionDecl(hasNameIn(names)));
+}
+
+// return the value mapped to the function with the given fully qualified name
+std::string LookupFunction(ASTUnit& ast, const QualifiedNameMap& names, const std::string& name) {
+  auto nodes = match(functionDecl(hasName(name)).bind("f"), ast.getASTContext());
+  EXPECT_EQ(nodes.size(), 1u);
+  const std::string* value = nodes.empty() ? nullptr :
+      names.lookup(*nodes.front().getNodeAs<FunctionDecl>("f"));
+  return value ? *value : std::string();
+}
+
+} // end of anonymous namespace
+
+TEST(MyASTMatchersTest, SLSizeMatchers) {
+  // classifiers are created per ASTContext, build the AST twice
+  for (int i = 0; i < 2; ++i) {
+    std::unique_ptr<ASTUnit> ast = tooling::buildASTFromCode(code);
+    ASSERT_TRUE(ast != nullptr);
+
+    EXPECT_EQ(CountMatches(*ast, callExpr(hasSLSizeCmpDecl())), 1u);
+    EXPECT_EQ(CountMatches(*ast, callExpr(hasSLSizeCastDecl())), 1u);
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasAnyName("a", "d", "h"), hasType(isSLSizeType()))), 3u);
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasAnyName("b", "e"), hasType(isIntType()))), 2u);
+    // SLSize is int but is not matched as int
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasAnyName("a", "d"), hasType(isIntType()))), 0u);
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasAnyName("c", "g"), hasType(isSizetType()))), 2u);
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasName("d"),
+                                         hasInitializer(ignoringImpCasts(expr(isSLSizeExpr()))))), 1u);
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasName("e"),
+                                         hasInitializer(ignoringImpCasts(expr(isIntExpr()))))), 1u);
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasName("g"),
+                                         hasInitializer(ignoringImpCasts(expr(isSizetExpr()))))), 1u);
+    EXPECT_EQ(CountMatches(*ast, cxxOperatorCallExpr(isBasicSLSizeExpr())), 1u);
+    // auto is spelled as its deduced type
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasName("n"), hasType(isSLSizeType()))), 1u);
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasName("i"),
+                                         hasInitializer(ignoringImpCasts(expr(isSLSizeExpr()))))), 1u);
+    EXPECT_EQ(CountMatches(*ast, varDecl(hasName("i"),
+                                         hasInitializer(ignoringImpCasts(expr(isIntExpr()))))), 0u);
+  }
+}
+
+TEST(MyASTMatchersTest, QualifiedNameMap) {
+  std::unique_ptr<ASTUnit> ast = tooling::buildASTFromCode(scopeCode);
+  ASSERT_TRUE(ast != nullptr);
+
+  // names are matched as by hasName()
+  for (const std::string name : {"Baz", "ns::Baz", "inner::Baz", "ns::inner::Baz",
+                                 "::ns::inner::Baz", "::Baz", "::inner::Baz", "ns::Baz::Baz",
+                                 "std::f", "std::__1::f", "::std::f", "__1::f", "f", "ns::f",
+                                 "h", "::h", "Local", "::Local", "g::Local"}) {
+    EXPECT_EQ(CountNameInMatches(*ast, name), CountMatches(*ast, functionDecl(hasName(name))))
+        << name;
+  }
+  EXPECT_EQ(CountNameInMatches(*ast, "Baz"), 3u);
+  EXPECT_EQ(CountNameInMatches(*ast, "::Baz"), 1u);
+  EXPECT_EQ(CountNameInMatches(*ast, "inner::Baz"), 1u);
+  EXPECT_EQ(CountNameInMatches(*ast, "std::f"), 1u);
+  EXPECT_EQ(CountNameInMatches(*ast, "::h"), 1u);
+
+  // members of class templates are matched with or without template arguments
+  EXPECT_EQ(CountNameInMatches(*ast, "Foo::bar"), 2u);
+  EXPECT_EQ(CountNameInMatches(*ast, "::Foo::bar"), 2u);
+  EXPECT_EQ(CountNameInMatches(*ast, "Foo<int>::bar"), 1u);
+  EXPECT_EQ(CountNameInMatches(*ast, "Foo<long>::bar"), 0u);
+
+  // the most qualified name is used
+  QualifiedNameMap names;
+  names.insert("Baz", "a");
+  names.insert("ns::Baz", "b");
+  names.insert("::Baz", "c");
+  names.insert("ns::Baz", "d");
+  EXPECT_EQ(names.size(), 3u);
+  EXPECT_EQ(LookupFunction(*ast, names, "::ns::Baz"), "d");
+  EXPECT_EQ(LookupFunction(*ast, names, "::ns::inner::Baz"), "a");
+  EXPECT_EQ(LookupFunction(*ast, names, "::Baz"), "c");
+  EXPECT_EQ(LookupFunction(*ast, names, "::std::f"), "");
+  EXPECT_EQ(names.getUnqualifiedNames(), std::vector<std::string>({"Baz"}));
+}
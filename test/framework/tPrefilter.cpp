@@ -0,0 +1,82 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Prefilter.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+
+TEST(PrefilterTest, SetTokens) {
+  Prefilter prefilter;
+  EXPECT_TRUE(prefilter.empty());
+  EXPECT_TRUE(prefilter.SetTokens({"foo", "_Bar2"}));
+  EXPECT_FALSE(prefilter.empty());
+  // only identifiers are looked up
+  EXPECT_FALSE(prefilter.SetTokens({"foo", "operator=="}));
+  EXPECT_TRUE(prefilter.empty());
+  EXPECT_FALSE(prefilter.SetTokens({"2foo"}));
+}
+
+TEST(PrefilterTest, Match) {
+  Prefilter prefilter;
+  ASSERT_TRUE(prefilter.SetTokens({"foo", "bar"}));
+  EXPECT_TRUE(prefilter.Match("int x = foo(1);"));
+  EXPECT_TRUE(prefilter.Match("a.bar"));
+  // tokens are matched as whole identifiers
+  EXPECT_FALSE(prefilter.Match("int x = foobar(1) + my_foo;"));
+  EXPECT_FALSE(prefilter.Match(""));
+}
+
+TEST(PrefilterTest, MatchFiles) {
+  std::vector<std::string> files = {"tmp_prefilter1.cpp", "tmp_prefilter2.cpp",
+                                    "tmp_prefilter_missing.cpp"};
+  std::ofstream(files[0]) << "void g() { foo(); }\n";
+  std::ofstream(files[1]) << "void g() { food(); }\n";
+  Prefilter prefilter;
+  ASSERT_TRUE(prefilter.SetTokens({"foo"}));
+  EXPECT_EQ(prefilter.MatchFiles(files, 2), std::vector<bool>({true, false, false}));
+  remove(files[0].c_str());
+  remove(files[1].c_str());
+}
+
+TEST(PrefilterTest, ScheduleLikelyFirst) {
+  std::vector<std::string> files;
+  for (int i = 0; i < 12; ++i) {
+    files.push_back("f" + std::to_string(i));
+  }
+  std::vector<bool> likely(files.size(), false);
+  likely[5] = likely[7] = likely[11] = true;
+  // 2 batches of 6 files, each starting with the files likely to match
+  auto scheduled = ScheduleLikelyFirst(files, likely, 2);
+  EXPECT_EQ(scheduled[0], "f5");
+  EXPECT_EQ(scheduled[6], "f7");
+  EXPECT_EQ(scheduled[1], "f11");
+  EXPECT_EQ(scheduled[7], "f0");
+  std::sort(scheduled.begin(), scheduled.end());
+  std::sort(files.begin(), files.end());
+  EXPECT_EQ(scheduled, files);
+}
@@ -0,0 +1,94 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Preflight.hpp"
+#include "IncludeGraph.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+// fixture class for Preflight suite
+class PreflightTest : public ::testing::Test {
+ protected:
+  IncludeGraph graph;
+  std::vector<std::string> files;
+
+  void SetUp() override {
+    // a.cpp: 10 bytes, b.cpp: 20 bytes, common.hpp: 100 bytes, b.hpp: 1000 bytes
+    WriteFile("tmp_preflight_a.cpp", 10);
+    WriteFile("tmp_preflight_b.cpp", 20);
+    WriteFile("tmp_preflight_common.hpp", 100);
+    WriteFile("tmp_preflight_b.hpp", 1000);
+    graph.SetIncludedHeaders("tmp_preflight_a.cpp", {"tmp_preflight_common.hpp"}, 1);
+    graph.SetIncludedHeaders("tmp_preflight_b.cpp",
+                             {"tmp_preflight_b.hpp", "tmp_preflight_common.hpp"}, 1);
+    files = {"tmp_preflight_a.cpp", "tmp_preflight_b.cpp"};
+  }
+
+  void TearDown() override {
+    for (const auto& file : {"tmp_preflight_a.cpp", "tmp_preflight_b.cpp",
+            "tmp_preflight_common.hpp", "tmp_preflight_b.hpp"}) {
+      remove(file);
+    }
+  }
+
+  static void WriteFile(const std::string& file, size_t size) {
+    std::ofstream ofs(file);
+    ofs << std::string(size, 'x');
+  }
+};
+
+TEST_F(PreflightTest, GetPreflightReport) {
+  auto report = GetPreflightReport(graph, files, 1, 10.0);
+  EXPECT_EQ(report.includeVolume, 110u + 1120u);
+  EXPECT_EQ(report.uniqueBytes, 1130u);
+  ASSERT_EQ(report.files.size(), 2u);
+  // the most expensive file comes first
+  EXPECT_EQ(report.files[0].file, "tmp_preflight_b.cpp");
+  EXPECT_EQ(report.files[0].numHeaders, 2u);
+  EXPECT_EQ(report.files[0].bytes, 1120u);
+  EXPECT_DOUBLE_EQ(report.files[0].seconds, 112.0);
+  // the header with the largest include volume comes first
+  ASSERT_EQ(report.headers.size(), 2u);
+  EXPECT_EQ(report.headers[0].header, "tmp_preflight_b.hpp");
+  EXPECT_EQ(report.headers[1].header, "tmp_preflight_common.hpp");
+  EXPECT_EQ(report.headers[1].numIncluders, 2u);
+  // both files are processed by one thread
+  EXPECT_EQ(report.numBatches, 1u);
+  EXPECT_DOUBLE_EQ(report.wallSeconds, 123.0);
+}
+
+TEST_F(PreflightTest, PrintPreflightReport) {
+  std::ostringstream oss;
+  PrintPreflightReport(GetPreflightReport(graph, files, 1), oss, 1);
+  std::string output = oss.str();
+  EXPECT_NE(output.find("Files: 2"), std::string::npos);
+  EXPECT_NE(output.find("tmp_preflight_b.cpp"), std::string::npos);
+  // only one entry is printed for each list
+  EXPECT_EQ(output.find("tmp_preflight_a.cpp"), std::string::npos);
+  EXPECT_EQ(output.find("tmp_preflight_common.hpp"), std::string::npos);
+}
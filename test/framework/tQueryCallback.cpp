@@ -0,0 +1,115 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+#include "QueryCallback.hpp"
+#include "CodeXformActionFactory.hpp"
+#include "CodeXformException.hpp"
+#include "MatchLimit.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "gtest/gtest.h"
+
+using namespace clang::tooling;
+
+TEST(QueryCallbackTest, ParseQuery) {
+  auto query = ParseQuery("callExpr()");
+  ASSERT_TRUE(query != nullptr);
+  // expressions are parsed once
+  EXPECT_EQ(ParseQuery("callExpr()"), query);
+  EXPECT_THROW(ParseQuery("callExpr("), CommandLineOptionException);
+}
+
+TEST(QueryCallbackTest, PrintMatches) {
+  std::string outputFile = "tmp_output_file.yaml";
+  std::vector<std::string> matchers = {kQueryMatcherId};
+  // calls to Foo, and calls to functions calling Foo in their body
+  std::vector<std::string> args = {
+    "--matcher-args-Query", "--expression",
+    "callExpr(callee(functionDecl(anyOf(hasName(\"Foo\"), "
+    "hasBody(hasDescendant(callExpr(callee(functionDecl(hasName(\"Foo\"))))))))))"};
+  FixedCompilationDatabase compilations(".", std::vector<std::string>());
+
+  std::vector<std::string> files = {"/virtual/query.cpp"};
+  ClangTool tool(compilations, files);
+  tool.mapVirtualFile("/virtual/query.hpp",
+                      "inline void Foo(int, int) {}\n"
+                      "inline void Wrap() { Foo(0, 0); }\n");
+  tool.mapVirtualFile(files.front(),
+                      "#include \"query.hpp\"\n"
+                      "void f() {\n"
+                      "  Wrap();\n"
+                      "  Foo(1,\n"
+                      "      2);\n"
+                      "}\n");
+  CodeXformActionFactory factory(outputFile, matchers, args);
+  testing::internal::CaptureStdout();
+  int status = tool.run(&factory);
+  std::string output = testing::internal::GetCapturedStdout();
+  remove(outputFile.c_str());
+  ASSERT_EQ(status, 0);
+
+  // the body of Wrap in the header is matched, but only main file nodes are
+  // printed, one line each
+  EXPECT_NE(output.find("/virtual/query.cpp:3:3: Wrap()\n"), std::string::npos) << output;
+  EXPECT_NE(output.find("/virtual/query.cpp:4:3: Foo(1, 2)\n"), std::string::npos) << output;
+  EXPECT_EQ(output.find("query.hpp"), std::string::npos) << output;
+}
+
+TEST(QueryCallbackTest, MaxMatches) {
+  std::string outputFile = "tmp_output_file.yaml";
+  std::vector<std::string> matchers = {kQueryMatcherId};
+  std::vector<std::string> args = {"--matcher-args-Query", "--expression",
+                                   "callExpr(callee(functionDecl(hasName(\"Foo\"))))"};
+  FixedCompilationDatabase compilations(".", std::vector<std::string>());
+  CodeXformOptions options;
+  options.matchLimit = std::make_shared<MatchLimit>(2);
+
+  // the first file has three matches, more than the limit
+  std::vector<std::string> files = {"/virtual/a.cpp", "/virtual/b.cpp"};
+  ClangTool tool(compilations, files);
+  for (const auto& file : files) {
+    tool.mapVirtualFile(file,
+                        "void Foo() {}\n"
+                        "void f() { Foo(); Foo(); Foo(); }\n");
+  }
+  CodeXformActionFactory factory(outputFile, matchers, args, options);
+  testing::internal::CaptureStdout();
+  int status = tool.run(&factory);
+  std::string output = testing::internal::GetCapturedStdout();
+  remove(outputFile.c_str());
+  ASSERT_EQ(status, 0);
+
+  // only the matches within the limit are printed, and the second file is skipped
+  EXPECT_EQ(options.matchLimit->count(), 2u);
+  EXPECT_NE(output.find("/virtual/a.cpp:2:12: Foo()\n"), std::string::npos) << output;
+  EXPECT_NE(output.find("/virtual/a.cpp:2:19: Foo()\n"), std::string::npos) << output;
+  EXPECT_EQ(output.find("/virtual/a.cpp:2:26:"), std::string::npos) << output;
+  EXPECT_EQ(output.find("/virtual/b.cpp"), std::string::npos) << output;
+}
@@ -0,0 +1,91 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Sampling.hpp"
+
+#include <map>
+
+#include "gtest/gtest.h"
+
+TEST(SamplingTest, SampleFiles) {
+  std::vector<std::string> files;
+  for (int i = 0; i < 60; ++i) {
+    files.push_back("/src/a/f" + std::to_string(i) + ".cpp");
+  }
+  for (int i = 0; i < 30; ++i) {
+    files.push_back("/src/a/b/f" + std::to_string(i) + ".cpp");
+    files.push_back("/src/c/f" + std::to_string(i) + ".cpp");
+  }
+  auto sample = SampleFiles(files, 0.1, 42);
+  ASSERT_EQ(sample.size(), 12u);
+  EXPECT_EQ(SampleFiles(files, 0.1, 42), sample);
+  // each directory contributes its share
+  std::map<std::string, int> numSampled;
+  for (const auto& file : sample) {
+    ++numSampled[file.substr(0, file.rfind('/'))];
+  }
+  EXPECT_EQ(numSampled["/src/a"], 6);
+  EXPECT_EQ(numSampled["/src/a/b"], 3);
+  EXPECT_EQ(numSampled["/src/c"], 3);
+  // at least one file is sampled
+  EXPECT_EQ(SampleFiles(files, 0.001, 42).size(), 1u);
+  EXPECT_EQ(SampleFiles(files, 1, 42).size(), files.size());
+}
+
+TEST(SamplingTest, EstimateTotals) {
+  SampleStats stats;
+  std::vector<std::string> sample = {"/src/a.cpp", "/src/b.cpp", "/src/c.cpp", "/src/d.cpp"};
+  FileStats fileStats;
+  fileStats.matches = 2;
+  fileStats.replacements = 1;
+  fileStats.replacementBytes = 10;
+  fileStats.seconds = 1;
+  for (const auto& file : sample) {
+    stats.Add(file, fileStats);
+  }
+  // a file compiled twice adds up, files not processed count as zero
+  stats.Add("/src/x/../a.cpp", fileStats);
+  sample.push_back("/src/e.cpp");
+
+  SampleEstimate estimate = EstimateTotals(stats, sample, 50, 1);
+  EXPECT_EQ(estimate.numFiles, 50u);
+  EXPECT_EQ(estimate.numSampled, 5u);
+  EXPECT_DOUBLE_EQ(estimate.matches.value, 100);
+  EXPECT_DOUBLE_EQ(estimate.replacements.value, 50);
+  EXPECT_DOUBLE_EQ(estimate.replacementBytes.value, 500);
+  EXPECT_DOUBLE_EQ(estimate.fileSeconds.value, 50);
+  EXPECT_TRUE(estimate.matches.hasMargin);
+  EXPECT_GT(estimate.matches.margin, 0);
+  EXPECT_EQ(estimate.numBatches, 1u);
+  EXPECT_DOUBLE_EQ(estimate.wallSeconds.value, 50);
+
+  // no sampling error if all the files are sampled
+  estimate = EstimateTotals(stats, sample, sample.size(), 1);
+  EXPECT_DOUBLE_EQ(estimate.matches.value, 10);
+  EXPECT_DOUBLE_EQ(estimate.matches.margin, 0);
+  // no interval with a single file
+  estimate = EstimateTotals(stats, {"/src/b.cpp"}, 50, 1);
+  EXPECT_DOUBLE_EQ(estimate.matches.value, 100);
+  EXPECT_FALSE(estimate.matches.hasMargin);
+}
@@ -0,0 +1,68 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "Server.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(ServerTest, EncodeMessage) {
+  std::vector<std::string> fields = {"abc", "", "1:2", std::string("a\0b", 3)};
+  std::string message = EncodeMessage(fields);
+  EXPECT_EQ(message, std::string("3:abc0:3:1:23:a\0b", 17));
+  std::vector<std::string> decoded;
+  ASSERT_TRUE(DecodeMessage(message, decoded));
+  EXPECT_EQ(decoded, fields);
+  EXPECT_FALSE(DecodeMessage("4:abc", decoded));
+  EXPECT_FALSE(DecodeMessage("abc", decoded));
+}
+
+TEST(ServerTest, EncodeRequest) {
+  ServerRequest request;
+  request.inputFiles = {"/src/a.cpp", "/src/b.cpp"};
+  request.matchers = {"RenameFcn"};
+  request.matcherArgs = {"--matcher-args-RenameFcn", "--qualified-name", "foo"};
+  request.numThreads = 4;
+  request.options.mainFileScope = true;
+  ServerRequest decoded;
+  ASSERT_TRUE(DecodeRequest(EncodeRequest(request), decoded));
+  EXPECT_EQ(decoded.inputFiles, request.inputFiles);
+  EXPECT_EQ(decoded.matchers, request.matchers);
+  EXPECT_EQ(decoded.matcherArgs, request.matcherArgs);
+  EXPECT_EQ(decoded.numThreads, 4u);
+  EXPECT_TRUE(decoded.options.mainFileScope);
+  EXPECT_FALSE(DecodeRequest(EncodeMessage({"unknown request"}), decoded));
+}
+
+TEST(ServerTest, EncodeResponse) {
+  ServerResponse response;
+  response.status = 1;
+  response.error = "error";
+  response.replacements = "---\nMainSourceFile: a.cpp\n...\n";
+  ServerResponse decoded;
+  ASSERT_TRUE(DecodeResponse(EncodeResponse(response), decoded));
+  EXPECT_EQ(decoded.status, 1);
+  EXPECT_EQ(decoded.error, response.error);
+  EXPECT_EQ(decoded.replacements, response.replacements);
+  EXPECT_FALSE(DecodeResponse(EncodeRequest(ServerRequest()), decoded));
+}
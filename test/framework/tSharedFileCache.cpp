@@ -0,0 +1,111 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "SharedFileCache.hpp"
+
+#include <fstream>
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+
+using namespace llvm;
+
+namespace {
+
+// return the content of the given file read through the given file system
+std::string ReadFile(vfs::FileSystem& fs, const std::string& file) {
+  auto result = fs.openFileForRead(file);
+  if (!result) {
+    return std::string();
+  }
+  auto buffer = (*result)->getBuffer(file);
+  return buffer ? buffer.get()->getBuffer().str() : std::string();
+}
+
+} // end anonymous namespace
+
+TEST(SharedFileCacheTest, CacheContent) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> memFS(new vfs::InMemoryFileSystem());
+  memFS->addFile("/src/a.cpp", 0, MemoryBuffer::getMemBuffer("int a;"));
+  IntrusiveRefCntPtr<SharedFileCache> cache(new SharedFileCache(memFS));
+
+  EXPECT_EQ(ReadFile(*cache, "/src/a.cpp"), "int a;");
+  EXPECT_EQ(ReadFile(*cache, "/src/a.cpp"), "int a;");
+  EXPECT_EQ(cache->GetNumCachedFiles(), 1u);
+  EXPECT_FALSE(cache->status("/src/b.cpp"));
+  EXPECT_EQ(cache->status("/src/a.cpp")->getName(), "/src/a.cpp");
+}
+
+TEST(SharedFileCacheTest, NewGeneration) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> memFS(new vfs::InMemoryFileSystem());
+  memFS->addFile("/src/a.cpp", 0, MemoryBuffer::getMemBuffer("int a;"));
+  IntrusiveRefCntPtr<SharedFileCache> cache(new SharedFileCache(memFS));
+  EXPECT_FALSE(cache->status("/src/b.cpp"));
+  EXPECT_EQ(ReadFile(*cache, "/src/a.cpp"), "int a;");
+
+  // new files are not visible until the next generation
+  memFS->addFile("/src/b.cpp", 0, MemoryBuffer::getMemBuffer("int b;"));
+  EXPECT_FALSE(cache->status("/src/b.cpp"));
+  cache->NewGeneration();
+  EXPECT_EQ(ReadFile(*cache, "/src/b.cpp"), "int b;");
+  EXPECT_EQ(ReadFile(*cache, "/src/a.cpp"), "int a;");
+  EXPECT_EQ(cache->GetNumCachedFiles(), 2u);
+}
+
+TEST(SharedFileCacheTest, ShareContent) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> memFS(new vfs::InMemoryFileSystem());
+  memFS->addFile("/inc/a.hpp", 0, MemoryBuffer::getMemBuffer("int a;"));
+  memFS->addHardLink("/inc/link/a.hpp", "/inc/a.hpp");
+  IntrusiveRefCntPtr<SharedFileCache> cache(new SharedFileCache(memFS));
+
+  EXPECT_EQ(ReadFile(*cache, "/inc/a.hpp"), "int a;");
+  EXPECT_EQ(ReadFile(*cache, "/inc/link/a.hpp"), "int a;");
+  // paths referring to the same file share the content
+  EXPECT_EQ(cache->GetNumCachedFiles(), 1u);
+  EXPECT_EQ(cache->status("/inc/link/a.hpp")->getName(), "/inc/link/a.hpp");
+}
+
+TEST(SharedFileCacheTest, RewriteFile) {
+  SmallString<256> file;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("clang-xform", "cpp", file));
+  std::ofstream(file.str().str()) << "int a;";
+  IntrusiveRefCntPtr<SharedFileCache> cache(new SharedFileCache());
+  auto opened = cache->openFileForRead(file);
+  ASSERT_TRUE(bool(opened));
+  auto buffer = (*opened)->getBuffer(file);
+  ASSERT_TRUE(bool(buffer));
+  EXPECT_EQ(buffer.get()->getBuffer(), "int a;");
+
+  // the cached content is not changed by rewriting the file
+  std::ofstream(file.str().str()) << "int a2;";
+  EXPECT_EQ(buffer.get()->getBuffer(), "int a;");
+  EXPECT_EQ(ReadFile(*cache, file.str().str()), "int a;");
+
+  // the new content is read in the next generation
+  cache->NewGeneration();
+  EXPECT_EQ(ReadFile(*cache, file.str().str()), "int a2;");
+  EXPECT_EQ(buffer.get()->getBuffer(), "int a;");
+  sys::fs::remove(file);
+}
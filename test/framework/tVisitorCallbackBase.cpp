@@ -0,0 +1,149 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "CodeXformActionFactory.hpp"
+#include "MatchCallbackDef.hpp"
+#include "MatcherHelper.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "clang/AST/Expr.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "gtest/gtest.h"
+
+using namespace clang;
+using namespace clang::tooling;
+
+namespace {
+
+int numFooCalls = 0;
+
+// visitor callback counting the calls to functions named Foo
+VISITOR_CALLBACK(CountingVisitorCallback);
+
+void CountingVisitorCallback::RegisterVisitors(VisitorDispatcher* dispatcher) {
+  dispatcher->AddVisitor<CallExpr>(this);
+}
+
+void CountingVisitorCallback::VisitStmt(const Stmt* stmt, ASTContext& context) {
+  const auto* call = llvm::cast<CallExpr>(stmt);
+  if (const auto* decl = call->getDirectCallee()) {
+    const IdentifierInfo* id = decl->getIdentifier();
+    if (id && id->getName() == "Foo") {
+      ++numFooCalls;
+    }
+  }
+}
+
+MatcherHelper<CountingVisitorCallback> RegisterCountingVisitorCallback("TestVisitorCallback");
+
+int numMatchedCalls = 0;
+
+// match callback counting all the calls
+MATCH_CALLBACK(CountingMatchCallback);
+
+void CountingMatchCallback::RegisterMatchers(clang::ast_matchers::MatchFinder* finder) {
+  finder->addMatcher(clang::ast_matchers::callExpr().bind("call"), this);
+}
+
+void CountingMatchCallback::run(const clang::ast_matchers::MatchFinder::MatchResult& Result) {
+  ++numMatchedCalls;
+}
+
+MatcherHelper<CountingMatchCallback> RegisterCountingMatchCallback("TestVisitorMatchCallback");
+
+const std::string source =
+    "void Foo() {}\n"
+    "struct S { void Foo() {} };\n"
+    "int main() { Foo(); S s; s.Foo(); return 0; }\n";
+
+} // end anonymous namespace
+
+TEST(VisitorCallbackBaseTest, VisitCallExprs) {
+  std::string outputFile = "tmp_output_file.yaml";
+  std::vector<std::string> matchers = {"TestVisitorCallback"};
+  std::vector<std::string> args;
+  FixedCompilationDatabase compilations(".", std::vector<std::string>());
+
+  ClangTool tool(compilations, {"/virtual/visitor.cpp"});
+  tool.mapVirtualFile("/virtual/visitor.cpp", source);
+  numFooCalls = 0;
+  CodeXformActionFactory factory(outputFile, matchers, args);
+  ASSERT_EQ(tool.run(&factory), 0);
+  remove(outputFile.c_str());
+
+  // CXXMemberCallExpr is a CallExpr
+  EXPECT_EQ(numFooCalls, 2);
+}
+
+TEST(VisitorCallbackBaseTest, VisitWithMatchers) {
+  std::string outputFile = "tmp_output_file.yaml";
+  std::vector<std::string> matchers = {"TestVisitorCallback", "TestVisitorMatchCallback"};
+  std::vector<std::string> args;
+  FixedCompilationDatabase compilations(".", std::vector<std::string>());
+
+  ClangTool tool(compilations, {"/virtual/visitor.cpp"});
+  tool.mapVirtualFile("/virtual/visitor.cpp", source);
+  numFooCalls = 0;
+  numMatchedCalls = 0;
+  CodeXformActionFactory factory(outputFile, matchers, args);
+  ASSERT_EQ(tool.run(&factory), 0);
+  remove(outputFile.c_str());
+
+  // the visitor and the matchers both run on the file
+  EXPECT_EQ(numFooCalls, 2);
+  EXPECT_EQ(numMatchedCalls, 2);
+}
+
+TEST(VisitorCallbackBaseTest, CalleeVisitors) {
+  std::string outputFile = "tmp_output_file.yaml";
+  // one instance per renamed function, each call reaches only the instance of its callee
+  std::vector<std::string> matchers = {"RenameFcn"};
+  std::vector<std::string> args = {"--matcher-args-RenameFcn", "--qualified-name", "::Foo",
+                                   "--new-name", "Bar",
+                                   "--matcher-args-RenameFcn", "--qualified-name", "S::Foo",
+                                   "--new-name", "Baz",
+                                   "--matcher-args-RenameFcn", "--qualified-name", "Qux",
+                                   "--new-name", "Quux"};
+  FixedCompilationDatabase compilations(".", std::vector<std::string>());
+
+  ClangTool tool(compilations, {"/virtual/visitor.cpp"});
+  tool.mapVirtualFile("/virtual/visitor.cpp", source);
+  CodeXformActionFactory factory(outputFile, matchers, args);
+  ASSERT_EQ(tool.run(&factory), 0);
+
+  std::ifstream ifs(outputFile);
+  std::string replacements((std::istreambuf_iterator<char>(ifs)),
+                           std::istreambuf_iterator<char>());
+  remove(outputFile.c_str());
+  EXPECT_NE(replacements.find("Bar"), std::string::npos);
+  EXPECT_NE(replacements.find("Baz"), std::string::npos);
+  EXPECT_EQ(replacements.find("Quux"), std::string::npos);
+}
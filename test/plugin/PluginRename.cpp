@@ -0,0 +1,72 @@
+/*
+  MIT License
+
+  Copyright (c) 2019 Xiaohong Chen
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+#include "MatchCallbackDef.hpp"
+#include "MatcherHelper.hpp"
+#include "ToolingUtil.hpp"
+
+#include <string>
+
+using namespace clang;
+using namespace clang::ast_matchers;
+
+// matcher plugin loaded by the MatcherFactory tests. It is built as a separate
+// library and registers its matcher into the test executable when loaded
+
+namespace {
+
+MATCH_CALLBACK(PluginRenameCallback);
+
+void PluginRenameCallback::RegisterMatchers(clang::ast_matchers::MatchFinder* finder) {
+  StatementMatcher PluginRenameMatcher =
+      callExpr(callee(functionDecl(hasName("PluginFoo"))),
+               isExpansionInMainFile()
+               ).bind("PluginRenameExpr");
+
+  finder->addMatcher(PluginRenameMatcher, this);
+  SetMainFileOnly();
+}
+
+void PluginRenameCallback::run(const clang::ast_matchers::MatchFinder::MatchResult& Result) {
+  const auto& srcMgr = Result.Context->getSourceManager();
+  const auto& langOpts = Result.Context->getLangOpts();
+
+  if (const CallExpr* PluginRenameExpr = Result.Nodes.getNodeAs<CallExpr>("PluginRenameExpr")) {
+    auto locBegin = srcMgr.getFileLoc(PluginRenameExpr->getCallee()->getExprLoc());
+    auto locEnd = srcMgr.getFileLoc(PluginRenameExpr->getCallee()->getEndLoc());
+    std::string newExprString = "PluginBar";
+    std::string oldExprString = getSourceText(locBegin, locEnd, srcMgr, langOpts);
+    ReplaceText(srcMgr, SourceRange(std::move(locBegin), std::move(locEnd)), newExprString);
+    LogReplacement(locBegin, srcMgr, oldExprString, newExprString);
+  }
+}
+
+#ifndef PLUGIN_DUPLICATE
+MatcherHelper<PluginRenameCallback> RegisterPluginRenameMatcher("PluginRename");
+#else
+// the same matcher registered under a new ID and the ID of a built-in matcher
+MatcherHelper<PluginRenameCallback> RegisterPluginDuplicateMatcher("PluginDuplicate");
+MatcherHelper<PluginRenameCallback> RegisterDuplicateMatcher("RenameFcn");
+#endif
+
+}
@@ -0,0 +1,35 @@
+namespace ns {
+void Baz() {}
+void CallBaz() { Baz(); }
+namespace inner {
+void Baz() {}
+void CallBaz() { Baz(); }
+}
+}
+
+namespace std {
+inline namespace __1 {
+void f() {}
+}
+void CallF() { f(); }
+}
+
+namespace {
+void h() {}
+}
+
+template <typename T>
+struct Foo {
+  void bar() {}
+};
+
+void Baz() {}
+
+int main() {
+  Baz();
+  h();
+  Foo<int> foo;
+  foo.bar();
+  Foo<double>().bar();
+  return 0;
+}
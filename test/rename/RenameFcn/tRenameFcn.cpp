@@ -1,8 +1,12 @@
 #include "CodeXformActionFactory.hpp"
 #include "ApplyReplacements.hpp"
+#include "MatchCallbackBase.hpp"
 #include "TestingUtil.hpp"
 #include "cxxlog.hpp"
 
+#include <cstdio>
+#include <fstream>
+#include <iterator>
 #include <vector>
 #include <string>
 
@@ -13,6 +17,19 @@
 
 using namespace cxxlog;
 using namespace clang::tooling;
+
+namespace {
+
+size_t CountOccurrences(const std::string& text, const std::string& pattern) {
+  size_t count = 0;
+  for (auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+} // end anonymous namespace
+
 // This unit test compares the log file and refactored src file with corresponding baseline.
 // The test is self-explained. The user does not need to make any changes here unless
 // for other customizations. It is recommended to check the following few places.
@@ -57,3 +74,123 @@ TEST(MatcherTest, RenameFcn) {
     ASSERT_TRUE(CompareFiles(refactoredFile, baselineFile));
   }
 }
+
+TEST(MatcherTest, RenameFcnMappingFile) {
+  // must start with test/
+  std::string dirPath = "test/rename/RenameFcn";
+  std::string logFile = "clang-xform.log";
+  std::string inputFile = "example.cpp";
+  std::string outputFile = "tmp_output_file.yaml";
+  std::string mappingFile = "tmp_mapping_file.txt";
+  // chdir dirPath, create outputFile, set logging properties
+  int status = InitTest(dirPath, inputFile, outputFile);
+  ASSERT_TRUE(status);
+  // setup log file
+  RegisterLogFile log_file(logFile);
+
+  {
+    std::ofstream ofs(mappingFile);
+    ofs << "# old,new\n"
+        << "Foo,Bar\n"
+        << "\n";
+  }
+
+  std::string refactoredFile = inputFile + ".refactored";
+  std::string baselineFile = inputFile + ".gold";
+  std::string baselineLog = logFile + ".gold";
+  std::vector<std::string> matchers = {"RenameFcn"};
+  std::vector<std::string> args = {"--matcher-args-RenameFcn", "--mapping-file", mappingFile};
+
+  // retrieve compliation database
+  std::string errMsg;
+  std::unique_ptr<CompilationDatabase> compilations =
+      CompilationDatabase::autoDetectFromSource(inputFile,
+                                                errMsg);
+  ASSERT_TRUE(compilations != nullptr);
+  clang::tooling::ClangTool tool(*compilations, inputFile);
+  status = tool.run(std::make_unique<CodeXformActionFactory>(outputFile, matchers, args).get());
+  ASSERT_EQ(status, 0);
+  // the mapping file renames the same calls as --qualified-name Foo --new-name Bar
+  ASSERT_TRUE(CompareFiles(logFile, baselineLog));
+
+  ApplyReplacements(outputFile, refactoredFile);
+  ASSERT_TRUE(CompareFiles(refactoredFile, baselineFile));
+}
+
+TEST(MatcherTest, RenameFcnScopes) {
+  // must start with test/
+  std::string dirPath = "test/rename/RenameFcn";
+  std::string logFile = "clang-xform.log";
+  std::string inputFile = "scopes.cpp";
+  std::string outputFile = "tmp_output_file.yaml";
+  std::string mappingFile = "tmp_mapping_file.txt";
+  // chdir dirPath, create outputFile, set logging properties
+  int status = InitTest(dirPath, inputFile, outputFile);
+  ASSERT_TRUE(status);
+  // setup log file
+  RegisterLogFile log_file(logFile);
+
+  // names are matched as by hasName(): inline and anonymous namespaces may be
+  // omitted, and a class template name matches all its specializations
+  {
+    std::ofstream ofs(mappingFile);
+    ofs << "ns::Baz , Qux\n"
+        << "std::f,g\n"
+        << "::h,k\n"
+        << "Foo::bar,baz\n";
+  }
+
+  std::string refactoredFile = inputFile + ".refactored";
+  std::string baselineFile = inputFile + ".gold";
+  std::string baselineLog = "scopes.log.gold";
+  std::vector<std::string> matchers = {"RenameFcn"};
+  std::vector<std::string> args = {"--matcher-args-RenameFcn", "--mapping-file", mappingFile};
+
+  // retrieve compliation database
+  std::string errMsg;
+  std::unique_ptr<CompilationDatabase> compilations =
+      CompilationDatabase::autoDetectFromSource(inputFile,
+                                                errMsg);
+  ASSERT_TRUE(compilations != nullptr);
+  clang::tooling::ClangTool tool(*compilations, inputFile);
+  status = tool.run(std::make_unique<CodeXformActionFactory>(outputFile, matchers, args).get());
+  ASSERT_EQ(status, 0);
+  // ns::inner::Baz and ::Baz are not renamed
+  ASSERT_TRUE(CompareFiles(logFile, baselineLog));
+
+  ApplyReplacements(outputFile, refactoredFile);
+  ASSERT_TRUE(CompareFiles(refactoredFile, baselineFile));
+
+  // the single name given by --qualified-name is matched in the same way
+  for (const auto& name : {"std::__1::f", "Foo<int>::bar"}) {
+    ASSERT_TRUE(InitTest(dirPath, inputFile, outputFile));
+    std::vector<std::string> nameArgs = {"--matcher-args-RenameFcn", "--qualified-name",
+                                         name, "--new-name", "renamed"};
+    status = tool.run(std::make_unique<CodeXformActionFactory>(outputFile, matchers, nameArgs).get());
+    ASSERT_EQ(status, 0);
+    std::ifstream ifs(outputFile);
+    std::string yaml((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    // Foo<double>::bar is not renamed by Foo<int>::bar
+    EXPECT_EQ(CountOccurrences(yaml, "ReplacementText: renamed"), 1u) << name;
+  }
+}
+
+TEST(MatcherTest, RenameFcnMappingFileReload) {
+  std::string mappingFile = "tmp_reload_mapping_file.txt";
+  std::vector<std::string> matchers = {"RenameFcn"};
+  std::vector<std::string> args = {"--matcher-args-RenameFcn", "--mapping-file", mappingFile};
+
+  // a mapping file edited between two runs, e.g. of a server, is read again
+  std::ofstream(mappingFile) << "Foo,Bar\n";
+  std::vector<std::string> tokens;
+  ASSERT_TRUE(GetPrefilterTokens(matchers, args, tokens));
+  EXPECT_EQ(tokens, std::vector<std::string>({"Foo"}));
+  ClearMatcherOptions();
+
+  std::ofstream(mappingFile) << "ns::Baz,Qux\n";
+  tokens.clear();
+  ASSERT_TRUE(GetPrefilterTokens(matchers, args, tokens));
+  EXPECT_EQ(tokens, std::vector<std::string>({"Baz"}));
+  ClearMatcherOptions();
+  remove(mappingFile.c_str());
+}